@@ -0,0 +1,24 @@
+#include "word_ladder.h"
+
+#include <iostream>
+
+// Compiles a newline-separated word list into the memory mappable lexicon format,
+// so solvers can start with word_ladder::map_lexicon instead of reading the text file.
+//   compile_lexicon english.txt english.wldx
+
+auto main(int argc, char* argv[]) -> int
+{
+    if (argc != 3) {
+        std::cerr << "Usage: " << argv[0] << " <lexicon.txt> <lexicon.wldx>\n";
+        return 1;
+    }
+    auto const lexicon = word_ladder::read_lexicon(argv[1]);
+    auto const indices = word_ladder::build_neighbour_indices(lexicon);
+    try {
+        word_ladder::save_lexicon(argv[2], indices);
+    } catch (const std::runtime_error& e) {
+        std::cerr << e.what() << "\n";
+        return 1;
+    }
+    std::cout << "Compiled " << lexicon.size() << " words into " << argv[2] << "\n";
+}
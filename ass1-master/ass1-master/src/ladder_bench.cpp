@@ -0,0 +1,158 @@
+#include "word_ladder.h"
+
+#include <algorithm>
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+#include <sys/resource.h>
+
+// Times solver::generate over a reproducible query corpus and prints latency percentiles,
+// search effort and peak memory per kind of query.
+//   ladder_bench [lexicon.txt] [queries per kind] [seed]
+// The corpus only depends on the lexicon and the seed, so two builds run with the same
+// arguments time exactly the same queries.
+
+namespace {
+
+struct query_kind {
+    std::string name;
+    std::vector<std::pair<std::string, std::string>> queries;
+};
+
+// Draws random same length pairs and keeps those each kind asks for, until every kind is full
+// or max_draws pairs have been drawn. Kinds the lexicon cannot fill are left short.
+auto build_corpus(word_ladder::solver& solver, std::size_t per_kind, std::uint32_t seed)
+    -> std::vector<query_kind> {
+    auto kinds = std::vector<query_kind>{{"short", {}}, {"long", {}}, {"unreachable", {}}, {"high fan-out", {}}};
+    auto rng = std::mt19937(seed);
+
+    // Words of lengths 3 to 8, where nearly all of the lexicon's ladders are, that have at
+    // least two words to pair up.
+    auto lengths = std::vector<std::size_t>{};
+    for (std::size_t length = 3; length <= 8; ++length) {
+        if (solver.index(length).size() >= 2) lengths.push_back(length);
+    }
+    if (lengths.empty()) return kinds;
+    // The words with most neighbours of each length, for the high fan-out queries.
+    auto hubs = std::vector<std::vector<word_ladder::word_id>>(lengths.size());
+    for (std::size_t l = 0; l < lengths.size(); ++l) {
+        auto const& index = solver.index(lengths[l]);
+        auto& ids = hubs[l];
+        for (word_ladder::word_id id = 0; id < index.size(); ++id) {
+            ids.push_back(id);
+        }
+        std::sort(ids.begin(), ids.end(), [&](word_ladder::word_id a, word_ladder::word_id b) {
+            return index.degree(a) > index.degree(b);
+        });
+        ids.resize(std::max<std::size_t>(ids.size() / 100, 2));
+    }
+
+    auto full = [&] {
+        return std::all_of(kinds.begin(), kinds.end(), [&](const query_kind& kind) {
+            return kind.queries.size() >= per_kind;
+        });
+    };
+    auto const max_draws = 200 * per_kind;
+    for (std::size_t draw = 0; draw < max_draws && !full(); ++draw) {
+        auto const l = rng() % lengths.size();
+        auto const& index = solver.index(lengths[l]);
+        auto pick = [&] { return static_cast<word_ladder::word_id>(rng() % index.size()); };
+        auto from = std::string(index.word(pick()));
+        auto to = std::string(index.word(pick()));
+        auto const steps = solver.distance(from, to);
+        auto* kind = !steps ? &kinds[2] : *steps <= 3 ? &kinds[0] : *steps >= 8 ? &kinds[1] : nullptr;
+        if (kind && kind->queries.size() < per_kind) {
+            kind->queries.emplace_back(from, to);
+        }
+
+        auto& hub = hubs[l];
+        auto hub_from = std::string(index.word(hub[rng() % hub.size()]));
+        auto hub_to = std::string(index.word(hub[rng() % hub.size()]));
+        if (kinds[3].queries.size() < per_kind && hub_from != hub_to && solver.distance(hub_from, hub_to)) {
+            kinds[3].queries.emplace_back(hub_from, hub_to);
+        }
+    }
+    return kinds;
+}
+
+auto percentile(const std::vector<double>& sorted, double p) -> double {
+    if (sorted.empty()) return 0;
+    auto const rank = static_cast<std::size_t>(p * static_cast<double>(sorted.size() - 1) + 0.5);
+    return sorted[rank];
+}
+
+// Peak resident set size of the process so far. It never goes down, so the growth across a
+// stretch of work is the most that work added on top of what was resident before it.
+auto peak_rss_kib() -> long {
+    rusage usage {};
+    getrusage(RUSAGE_SELF, &usage);
+    return usage.ru_maxrss;
+}
+
+} // namespace
+
+auto main(int argc, char* argv[]) -> int
+{
+    auto const path = std::string(argc > 1 ? argv[1] : "./english.txt");
+    auto const per_kind = argc > 2 ? std::stoul(argv[2]) : 200UL;
+    auto const seed = argc > 3 ? static_cast<std::uint32_t>(std::stoul(argv[3])) : 6771U;
+    if (per_kind == 0) {
+        std::cerr << "ladder_bench: queries per kind must be at least 1\n";
+        return 1;
+    }
+
+    auto const lexicon = word_ladder::read_lexicon(path);
+    auto solver = word_ladder::solver(lexicon);
+    auto const kinds = build_corpus(solver, per_kind, seed);
+    for (auto const& kind : kinds) {
+        if (kind.queries.size() < per_kind) {
+            std::cerr << "ladder_bench: found only " << kind.queries.size() << " of " << per_kind << " "
+                      << kind.name << " queries in " << path << "\n";
+        }
+    }
+    // Picking the corpus built landmark indices, which generate never uses, so only the
+    // growth from here on is down to the timed queries.
+    auto const rss_before = peak_rss_kib();
+
+    std::cout << std::left << std::setw(14) << "queries" << std::right
+              << std::setw(8) << "count" << std::setw(11) << "p50 us" << std::setw(11) << "p95 us"
+              << std::setw(11) << "p99 us" << std::setw(13) << "expanded" << std::setw(13) << "scanned"
+              << std::setw(11) << "ladders" << "\n";
+    for (auto const& kind : kinds) {
+        auto micros = std::vector<double>();
+        auto expanded = std::size_t{0};
+        auto scanned = std::size_t{0};
+        auto ladders = std::size_t{0};
+        for (auto const& [from, to] : kind.queries) {
+            auto const start = std::chrono::steady_clock::now();
+            auto const result = solver.generate(from, to);
+            auto const stop = std::chrono::steady_clock::now();
+            micros.push_back(std::chrono::duration<double, std::micro>(stop - start).count());
+            ladders += result.size();
+            // An unreachable pair is rejected before searching and leaves no steps behind.
+            if (result.empty()) continue;
+            for (auto const& step : solver.last_search().steps) {
+                expanded += step.expanded_from_side ? step.from_size : step.to_size;
+                scanned += step.expanded_from_side ? step.from_cost : step.to_cost;
+            }
+        }
+        std::sort(micros.begin(), micros.end());
+        auto const count = kind.queries.size();
+        if (count == 0) continue;
+        std::cout << std::left << std::setw(14) << kind.name << std::right << std::fixed << std::setprecision(1)
+                  << std::setw(8) << count
+                  << std::setw(11) << percentile(micros, 0.50)
+                  << std::setw(11) << percentile(micros, 0.95)
+                  << std::setw(11) << percentile(micros, 0.99)
+                  << std::setw(13) << static_cast<double>(expanded) / static_cast<double>(count)
+                  << std::setw(13) << static_cast<double>(scanned) / static_cast<double>(count)
+                  << std::setw(11) << static_cast<double>(ladders) / static_cast<double>(count) << "\n";
+    }
+    std::cout << "expanded and scanned are words expanded and neighbours scanned per query.\n";
+    std::cout << "peak RSS " << rss_before << " KiB before the timed queries, "
+              << peak_rss_kib() - rss_before << " KiB more during them\n";
+}
@@ -1,5 +1,19 @@
 #include "word_ladder.h"
 
+#include <array>
+#include <condition_variable>
+#include <cstring>
+#include <deque>
+#include <limits>
+#include <mutex>
+#include <thread>
+#include <tuple>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
 auto word_ladder::read_lexicon(const std::string &path) -> std::unordered_set<std::string> {
 	std::ifstream in_file(path, std::ios::in);
 	if (!in_file.is_open()) {
@@ -16,8 +30,8 @@ auto word_ladder::read_lexicon(const std::string &path) -> std::unordered_set<st
 }
 
 auto word_ladder::less_comparator(
-    const std::vector<std::string> v1, 
-    const std::vector<std::string> v2
+    const std::vector<std::string> &v1,
+    const std::vector<std::string> &v2
 ) -> bool {
 	return v1 < v2;
 }
@@ -28,138 +42,1987 @@ auto word_ladder::filtered_dict(
 ) -> std::unordered_set<std::string_view> {
 	std::unordered_set<std::string_view> dict;
     for (const auto &word : lexicon) {
-        if (word.size() == length) {
+        if (code_points(word) == length) {
             dict.insert(std::string_view {word});
         }
     }
     return dict;
 }
 
-void word_ladder::swap_set_with_smaller_len(
-    std::unordered_set<std::string> &begin_set, 
-    std::unordered_set<std::string> &end_set, 
-    bool &reversed, 
-    std::unordered_map<std::string, std::vector<std::vector<std::string>>> &begin_map,
-    std::unordered_map<std::string, std::vector<std::vector<std::string>>> &end_map
-) {
-	if (begin_set.size() > end_set.size()) {
-        std::swap(begin_set, end_set);
-        std::swap(begin_map, end_map);
-        reversed = !reversed;
+auto word_ladder::code_points(std::string_view word) noexcept -> std::size_t {
+	std::size_t count = 0;
+	for (auto ch : word) {
+		count += (static_cast<unsigned char>(ch) & 0xC0) != 0x80;
+	}
+	return count;
+}
+
+namespace {
+// Byte offset of every code point of word into starts, followed by word.size().
+void code_point_starts(std::string_view word, std::vector<std::size_t> &starts) {
+	starts.clear();
+	for (std::size_t i = 0; i < word.size(); ++i) {
+		if ((static_cast<unsigned char>(word[i]) & 0xC0) != 0x80) starts.push_back(i);
+	}
+	starts.push_back(word.size());
+}
+
+// The value of the code point made up of the bytes of letter.
+auto decode(std::string_view letter) noexcept -> char32_t {
+	auto const lead = static_cast<unsigned char>(letter[0]);
+	if (letter.size() == 1) return lead;
+	char32_t value = lead & (0x7FU >> letter.size());
+	for (std::size_t i = 1; i < letter.size(); ++i) {
+		value = (value << 6) | (static_cast<unsigned char>(letter[i]) & 0x3FU);
+	}
+	return value;
+}
+
+// The code point at position pos of word.
+auto code_point_at(std::string_view word, std::size_t pos) noexcept -> char32_t {
+	std::size_t start = 0;
+	for (; pos > 0; --pos) {
+		do ++start; while (start < word.size() && (static_cast<unsigned char>(word[start]) & 0xC0) == 0x80);
+	}
+	auto end = start + 1;
+	while (end < word.size() && (static_cast<unsigned char>(word[end]) & 0xC0) == 0x80) ++end;
+	return decode(word.substr(start, end - start));
+}
+
+// FNV-1a, finished with a 64 bit mixer so every bit of the result depends on every letter.
+auto hash_word(std::string_view word) noexcept -> std::uint64_t {
+	std::uint64_t hash = 14695981039346656037ULL;
+	for (auto ch : word) {
+		hash ^= static_cast<unsigned char>(ch);
+		hash *= 1099511628211ULL;
+	}
+	hash ^= hash >> 33;
+	hash *= 0xff51afd7ed558ccdULL;
+	hash ^= hash >> 33;
+	return hash;
+}
+
+// A displacement with this bit set names the slot of a one word bucket directly.
+constexpr std::uint32_t direct_slot = 0x80000000U;
+
+auto displaced_slot(std::uint64_t hash, std::uint32_t displacement, std::size_t slots) noexcept -> std::size_t {
+	if (displacement & direct_slot) {
+		return displacement & ~direct_slot;
+	}
+	auto mixed = hash ^ (displacement * 0x9e3779b97f4a7c15ULL);
+	mixed ^= mixed >> 29;
+	mixed *= 0xbf58476d1ce4e5b9ULL;
+	mixed ^= mixed >> 32;
+	return static_cast<std::size_t>(mixed % slots);
+}
+
+// Hash of the wildcard pattern of word that replaces its bytes cut up to cut_end by '*'.
+auto hash_pattern(std::string_view word, std::size_t cut, std::size_t cut_end) noexcept -> std::uint64_t {
+	std::uint64_t hash = 14695981039346656037ULL;
+	auto const mix = [&hash](char ch) {
+		hash ^= static_cast<unsigned char>(ch);
+		hash *= 1099511628211ULL;
+	};
+	for (std::size_t i = 0; i < cut; ++i) mix(word[i]);
+	mix('*');
+	for (std::size_t i = cut_end; i < word.size(); ++i) mix(word[i]);
+	hash ^= hash >> 33;
+	hash *= 0xff51afd7ed558ccdULL;
+	hash ^= hash >> 33;
+	return hash;
+}
+
+// One wildcard pattern of one word, while the buckets of an index are built: word id with
+// the code point at pos, which takes bytes cut up to cut_end, replaced by '*'.
+struct pattern_entry {
+	std::uint64_t hash;
+	word_ladder::word_id id;
+	std::uint32_t pos;
+	std::uint32_t cut;
+	std::uint32_t cut_end;
+};
+
+// Sort entries by the low 32 bits of their hash, with an LSD radix sort of a byte per pass.
+void sort_by_low_hash(std::vector<pattern_entry> &entries) {
+	std::vector<pattern_entry> sorted(entries.size());
+	for (unsigned shift = 0; shift < 32; shift += 8) {
+		std::size_t starts[257] = {};
+		for (const auto &e : entries) {
+			++starts[((e.hash >> shift) & 0xFFU) + 1];
+		}
+		for (std::size_t digit = 0; digit < 256; ++digit) {
+			starts[digit + 1] += starts[digit];
+		}
+		for (const auto &e : entries) {
+			sorted[starts[(e.hash >> shift) & 0xFFU]++] = e;
+		}
+		entries.swap(sorted);
+	}
+}
+
+// Arrays of an index built in memory, which its views point into.
+struct owned_index {
+	std::vector<char> text;
+	std::vector<std::uint32_t> word_offsets;
+	std::vector<std::uint32_t> bucket_offsets;
+	std::vector<word_ladder::word_id> bucket_words;
+	std::vector<std::uint32_t> word_buckets;
+	std::vector<std::uint32_t> hash_displacements;
+	std::vector<word_ladder::word_id> hash_slots;
+	std::vector<std::uint64_t> packed;
+	std::vector<std::uint32_t> components;
+};
+
+// Hash and displace: the words are split into buckets of about three by hash, and the
+// buckets, largest first, are each given the first displacement that sends all of their
+// words to free slots. One word buckets go last and just take the next free slot.
+void build_perfect_hash(const word_ladder::neighbour_index &index, owned_index &owned) {
+	auto const count = index.size();
+	auto const buckets = count / 3 + 1;
+	std::vector<std::vector<word_ladder::word_id>> members(buckets);
+	std::vector<std::uint64_t> hashes(count);
+	for (std::size_t id = 0; id < count; ++id) {
+		hashes[id] = hash_word(index.word(static_cast<word_ladder::word_id>(id)));
+		members[hashes[id] % buckets].push_back(static_cast<word_ladder::word_id>(id));
+	}
+	std::vector<std::size_t> order(buckets);
+	for (std::size_t b = 0; b < buckets; ++b) {
+		order[b] = b;
+	}
+	std::stable_sort(order.begin(), order.end(), [&](std::size_t a, std::size_t b) {
+		return members[a].size() > members[b].size();
+	});
+
+	owned.hash_displacements.assign(buckets, 0);
+	owned.hash_slots.assign(count, 0);
+	std::vector<std::uint8_t> taken(count, 0);
+	std::vector<std::size_t> slots;
+	std::size_t next_free = 0;
+	for (auto b : order) {
+		if (members[b].empty()) break;
+		if (members[b].size() == 1) {
+			while (taken[next_free]) ++next_free;
+			taken[next_free] = 1;
+			owned.hash_slots[next_free] = members[b].front();
+			owned.hash_displacements[b] = direct_slot | static_cast<std::uint32_t>(next_free);
+			continue;
+		}
+		for (std::uint32_t displacement = 1;; ++displacement) {
+			slots.clear();
+			for (auto id : members[b]) {
+				auto slot = displaced_slot(hashes[id], displacement, count);
+				if (taken[slot] || std::find(slots.begin(), slots.end(), slot) != slots.end()) break;
+				slots.push_back(slot);
+			}
+			if (slots.size() != members[b].size()) continue;
+			for (std::size_t i = 0; i < slots.size(); ++i) {
+				taken[slots[i]] = 1;
+				owned.hash_slots[slots[i]] = members[b][i];
+			}
+			owned.hash_displacements[b] = displacement;
+			break;
+		}
+	}
+}
+
+// Union-find over the buckets: every word of a bucket joins the component of its first
+// word. The roots are then renumbered densely in order of their smallest word.
+void label_components(const word_ladder::neighbour_index &index, owned_index &owned) {
+	std::vector<std::uint32_t> parent(index.size());
+	for (std::size_t id = 0; id < parent.size(); ++id) {
+		parent[id] = static_cast<std::uint32_t>(id);
+	}
+	auto root = [&parent](std::uint32_t id) {
+		while (parent[id] != id) {
+			parent[id] = parent[parent[id]];
+			id = parent[id];
+		}
+		return id;
+	};
+	for (std::size_t b = 0; b + 1 < index.bucket_offsets.size(); ++b) {
+		auto first = root(index.bucket_words[index.bucket_offsets[b]]);
+		for (auto i = index.bucket_offsets[b] + 1; i < index.bucket_offsets[b + 1]; ++i) {
+			auto const other = root(index.bucket_words[i]);
+			// Hang the later root under the earlier one so roots stay the smallest ids.
+			if (other < first) {
+				parent[first] = other;
+				first = other;
+			} else if (other != first) {
+				parent[other] = first;
+			}
+		}
+	}
+
+	owned.components.resize(parent.size());
+	std::uint32_t labels = 0;
+	for (std::size_t id = 0; id < parent.size(); ++id) {
+		auto const r = root(static_cast<std::uint32_t>(id));
+		owned.components[id] = r == id ? labels++ : owned.components[r];
+	}
+}
+
+// Layout of a compiled lexicon: a header, one section per word length, then the arrays.
+constexpr char lexicon_magic[8] = {'W', 'L', 'A', 'D', 'D', 'E', 'R', '4'};
+
+struct lexicon_header {
+	char magic[8];
+	std::uint64_t lengths;
+};
+
+struct lexicon_section {
+	std::uint64_t count;
+	std::uint64_t text_bytes;
+	std::uint64_t word_offsets;
+	std::uint64_t word_offsets_count;
+	std::uint64_t buckets;
+	std::uint64_t displacements;
+	std::uint64_t text;
+	std::uint64_t bucket_offsets;
+	std::uint64_t bucket_words;
+	std::uint64_t word_buckets;
+	std::uint64_t hash_displacements;
+	std::uint64_t hash_slots;
+	std::uint64_t packed;
+	std::uint64_t packed_count;
+	std::uint64_t components;
+};
+} // namespace
+
+auto word_ladder::neighbour_index::size() const noexcept -> std::size_t {
+	if (!word_offsets.empty()) return word_offsets.size() - 1;
+	return length == 0 ? hash_slots.size() : text.size() / length;
+}
+
+auto word_ladder::neighbour_index::word(word_id id) const noexcept -> std::string_view {
+	if (!word_offsets.empty()) {
+		return std::string_view(text.data() + word_offsets[id], word_offsets[id + 1] - word_offsets[id]);
+	}
+	return std::string_view(text.data() + id * length, length);
+}
+
+auto word_ladder::neighbour_index::find(std::string_view word) const noexcept -> std::optional<word_id> {
+	if (hash_displacements.empty()) return find_sorted(word);
+	if (hash_slots.empty() || (word_offsets.empty() && word.size() != length)) return std::nullopt;
+	auto const hash = hash_word(word);
+	auto const displacement = hash_displacements[hash % hash_displacements.size()];
+	auto const id = hash_slots[displaced_slot(hash, displacement, hash_slots.size())];
+	if (this->word(id) != word) return std::nullopt;
+	return id;
+}
+
+auto word_ladder::neighbour_index::find_sorted(std::string_view word) const noexcept -> std::optional<word_id> {
+	if (size() == 0 || (word_offsets.empty() && word.size() != length)) return std::nullopt;
+	if (length == 0) return word_id {0};
+	std::size_t low = 0;
+	std::size_t high = size();
+	while (low < high) {
+		auto const mid = low + (high - low) / 2;
+		auto const cmp = word_offsets.empty()
+		    ? std::memcmp(text.data() + mid * length, word.data(), length)
+		    : this->word(static_cast<word_id>(mid)).compare(word);
+		if (cmp == 0) return static_cast<word_id>(mid);
+		if (cmp < 0) {
+			low = mid + 1;
+		} else {
+			high = mid;
+		}
+	}
+	return std::nullopt;
+}
+
+auto word_ladder::neighbour_index::bucket(word_id id, std::size_t pos) const -> std::span<const word_id> {
+	auto b = word_buckets[id * length + pos];
+	return bucket_words.subspan(bucket_offsets[b], bucket_offsets[b + 1] - bucket_offsets[b]);
+}
+
+auto word_ladder::pack_word(std::string_view word) noexcept -> std::optional<std::uint64_t> {
+	if (word.size() > max_packed_length) return std::nullopt;
+	std::uint64_t code = 0;
+	for (std::size_t i = 0; i < word.size(); ++i) {
+		if (word[i] < 'a' || word[i] > 'z') return std::nullopt;
+		code |= static_cast<std::uint64_t>(word[i] - 'a') << (5 * i);
+	}
+	return code;
+}
+
+auto word_ladder::neighbour_index::degree(word_id id) const -> std::size_t {
+	std::size_t degree = 0;
+	for (std::size_t pos = 0; pos < length; ++pos) {
+		auto b = word_buckets[id * length + pos];
+		degree += bucket_offsets[b + 1] - bucket_offsets[b] - 1;
+	}
+	return degree;
+}
+
+auto word_ladder::neighbour_index::connected(word_id from, word_id to) const noexcept -> bool {
+	return components.empty() || components[from] == components[to];
+}
+
+auto word_ladder::build_neighbour_index(
+    std::size_t length,
+    const std::unordered_set<std::string> &lexicon,
+    index_parts parts
+) -> neighbour_index {
+	std::vector<std::string_view> words;
+	for (const auto &word : lexicon) {
+		if (code_points(word) == length) {
+			words.emplace_back(word);
+		}
+	}
+	return build_neighbour_index(length, std::move(words), parts);
+}
+
+auto word_ladder::build_neighbour_index(
+    std::size_t length,
+    std::vector<std::string_view> words,
+    index_parts parts
+) -> neighbour_index {
+	std::sort(words.begin(), words.end());
+	auto owned = std::make_shared<owned_index>();
+	owned->text.reserve(words.size() * length);
+	bool const ascii = std::all_of(words.begin(), words.end(), [length](std::string_view word) {
+		return word.size() == length;
+	});
+	for (const auto &word : words) {
+		if (!ascii) owned->word_offsets.push_back(static_cast<std::uint32_t>(owned->text.size()));
+		owned->text.insert(owned->text.end(), word.begin(), word.end());
+	}
+	if (!ascii) owned->word_offsets.push_back(static_cast<std::uint32_t>(owned->text.size()));
+
+	// One entry per wildcard pattern of every word. Sorting them brings the words of each
+	// pattern together without building a single pattern string.
+	std::vector<pattern_entry> entries;
+	entries.reserve(words.size() * length);
+	std::vector<std::size_t> starts;
+	for (std::size_t id = 0; id < words.size(); ++id) {
+		auto const word = words[id];
+		if (!ascii) code_point_starts(word, starts);
+		for (std::size_t i = 0; i < length; ++i) {
+			auto const cut = ascii ? i : starts[i];
+			auto const cut_end = ascii ? i + 1 : starts[i + 1];
+			entries.push_back({
+			    hash_pattern(word, cut, cut_end),
+			    static_cast<word_id>(id),
+			    static_cast<std::uint32_t>(i),
+			    static_cast<std::uint32_t>(cut),
+			    static_cast<std::uint32_t>(cut_end),
+			});
+		}
+	}
+	// The rest of the word either side of the wildcard.
+	auto const prefix = [&words](const pattern_entry &e) { return words[e.id].substr(0, e.cut); };
+	auto const suffix = [&words](const pattern_entry &e) { return words[e.id].substr(e.cut_end); };
+	auto const same_pattern = [&](const pattern_entry &a, const pattern_entry &b) {
+		return a.hash == b.hash && a.pos == b.pos && prefix(a) == prefix(b) && suffix(a) == suffix(b);
+	};
+	sort_by_low_hash(entries);
+	// Entries of one pattern now sit in a run of equal low hash bits, which only rarely holds
+	// another pattern as well; sort each run to split those apart.
+	for (std::size_t first = 0, last = 0; first < entries.size(); first = last) {
+		auto const low = static_cast<std::uint32_t>(entries[first].hash);
+		while (last < entries.size() && static_cast<std::uint32_t>(entries[last].hash) == low) ++last;
+		if (last - first < 2) continue;
+		std::sort(entries.begin() + static_cast<std::ptrdiff_t>(first), entries.begin() + static_cast<std::ptrdiff_t>(last),
+		    [&](const pattern_entry &a, const pattern_entry &b) {
+			    if (a.hash != b.hash) return a.hash < b.hash;
+			    if (a.pos != b.pos) return a.pos < b.pos;
+			    if (auto const cmp = prefix(a).compare(prefix(b)); cmp != 0) return cmp < 0;
+			    return suffix(a) < suffix(b);
+		    });
+	}
+	owned->word_buckets.resize(entries.size());
+	std::uint32_t buckets = 0;
+	for (std::size_t e = 0; e < entries.size(); ++e) {
+		if (e > 0 && !same_pattern(entries[e - 1], entries[e])) ++buckets;
+		owned->word_buckets[entries[e].id * length + entries[e].pos] = buckets;
+	}
+	if (!entries.empty()) ++buckets;
+
+	// Renumber the buckets in order of their first word and position, like a walk over the
+	// words in id order would have found them, and count their words.
+	std::vector<std::uint32_t> renumbered(buckets, UINT32_MAX);
+	std::uint32_t next = 0;
+	owned->bucket_offsets.assign(buckets + 1, 0);
+	for (auto &b : owned->word_buckets) {
+		if (renumbered[b] == UINT32_MAX) renumbered[b] = next++;
+		b = renumbered[b];
+		++owned->bucket_offsets[b + 1];
+	}
+	for (std::size_t b = 0; b < buckets; ++b) {
+		owned->bucket_offsets[b + 1] += owned->bucket_offsets[b];
+	}
+	// Words are placed in id order, so every bucket comes out sorted.
+	std::vector<std::uint32_t> fill(owned->bucket_offsets.begin(), owned->bucket_offsets.end() - 1);
+	owned->bucket_words.resize(entries.size());
+	for (std::size_t i = 0; i < owned->word_buckets.size(); ++i) {
+		owned->bucket_words[fill[owned->word_buckets[i]]++] = static_cast<word_id>(i / length);
+	}
+
+	neighbour_index index;
+	index.length = length;
+	index.text = owned->text;
+	index.word_offsets = owned->word_offsets;
+	index.bucket_offsets = owned->bucket_offsets;
+	index.bucket_words = owned->bucket_words;
+	index.word_buckets = owned->word_buckets;
+	// size() of a length 0 index counts hash slots, so give it its one word up front.
+	owned->hash_slots.resize(words.size());
+	index.hash_slots = owned->hash_slots;
+	if (parts == index_parts::buckets) {
+		index.storage = std::move(owned);
+		return index;
+	}
+	build_perfect_hash(index, *owned);
+	index.hash_displacements = owned->hash_displacements;
+	index.hash_slots = owned->hash_slots;
+	for (const auto &word : words) {
+		auto code = pack_word(word);
+		if (!code) {
+			owned->packed.clear();
+			break;
+		}
+		owned->packed.push_back(*code);
+	}
+	index.packed = owned->packed;
+	label_components(index, *owned);
+	index.components = owned->components;
+	index.storage = std::move(owned);
+	return index;
+}
+
+auto word_ladder::build_neighbour_indices(const std::unordered_set<std::string> &lexicon)
+    -> std::vector<neighbour_index> {
+	std::vector<std::vector<std::string_view>> by_length;
+	for (const auto &word : lexicon) {
+		auto const length = code_points(word);
+		if (length >= by_length.size()) {
+			by_length.resize(length + 1);
+		}
+		by_length[length].push_back(std::string_view {word});
+	}
+	std::vector<neighbour_index> indices;
+	indices.reserve(by_length.size());
+	for (std::size_t length = 0; length < by_length.size(); ++length) {
+		indices.push_back(build_neighbour_index(length, std::move(by_length[length])));
+	}
+	return indices;
+}
+
+void word_ladder::save_lexicon(const std::string &path, std::span<const neighbour_index> indices) {
+	std::uint64_t offset = sizeof(lexicon_header) + indices.size() * sizeof(lexicon_section);
+	auto place = [&offset](std::size_t bytes) {
+		auto at = offset;
+		offset = (offset + bytes + 7) / 8 * 8;
+		return at;
+	};
+	std::vector<lexicon_section> sections;
+	for (const auto &index : indices) {
+		// map_lexicon expects the lookup table and component labels of every word.
+		if (index.hash_slots.size() != index.size() || index.components.size() != index.size()) {
+			throw std::runtime_error("Cannot save a buckets only index: " + path);
+		}
+		lexicon_section section {};
+		section.count = index.size();
+		section.text_bytes = index.text.size();
+		section.word_offsets = place(index.word_offsets.size_bytes());
+		section.word_offsets_count = index.word_offsets.size();
+		section.buckets = index.bucket_offsets.empty() ? 0 : index.bucket_offsets.size() - 1;
+		section.displacements = index.hash_displacements.size();
+		section.text = place(index.text.size_bytes());
+		section.bucket_offsets = place(index.bucket_offsets.size_bytes());
+		section.bucket_words = place(index.bucket_words.size_bytes());
+		section.word_buckets = place(index.word_buckets.size_bytes());
+		section.hash_displacements = place(index.hash_displacements.size_bytes());
+		section.hash_slots = place(index.hash_slots.size_bytes());
+		section.packed = place(index.packed.size_bytes());
+		section.packed_count = index.packed.size();
+		section.components = place(index.components.size_bytes());
+		sections.push_back(section);
+	}
+
+	std::ofstream out(path, std::ios::binary | std::ios::trunc);
+	if (!out.is_open()) {
+		throw std::runtime_error("Cannot write compiled lexicon: " + path);
+	}
+	lexicon_header header {};
+	std::copy(std::begin(lexicon_magic), std::end(lexicon_magic), header.magic);
+	header.lengths = indices.size();
+	out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+	out.write(reinterpret_cast<const char*>(sections.data()), static_cast<std::streamsize>(sections.size() * sizeof(lexicon_section)));
+	auto write = [&out](std::uint64_t at, auto array) {
+		out.seekp(static_cast<std::streamoff>(at));
+		out.write(reinterpret_cast<const char*>(array.data()), static_cast<std::streamsize>(array.size_bytes()));
+	};
+	for (std::size_t length = 0; length < indices.size(); ++length) {
+		const auto &index = indices[length];
+		const auto &section = sections[length];
+		write(section.text, index.text);
+		write(section.word_offsets, index.word_offsets);
+		write(section.bucket_offsets, index.bucket_offsets);
+		write(section.bucket_words, index.bucket_words);
+		write(section.word_buckets, index.word_buckets);
+		write(section.hash_displacements, index.hash_displacements);
+		write(section.hash_slots, index.hash_slots);
+		write(section.packed, index.packed);
+		write(section.components, index.components);
+	}
+	// Pad to the end of the last array so every section lies inside the file.
+	if (offset > 0) {
+		out.seekp(static_cast<std::streamoff>(offset - 1));
+		out.put('\0');
+	}
+	if (!out) {
+		throw std::runtime_error("Cannot write compiled lexicon: " + path);
+	}
+}
+
+namespace {
+// Whether every offset, id and bucket number in the arrays of index points inside the array
+// it indexes, so that no lookup can read outside the mapping. Says nothing about whether
+// the words are sorted or the buckets right; a file that lies about those gives wrong
+// ladders, but never reads out of bounds.
+auto consistent(const word_ladder::neighbour_index &index, const lexicon_section &section) -> bool {
+	auto const count = section.count;
+	auto const below = [](auto array, std::uint64_t bound) {
+		return std::all_of(array.begin(), array.end(), [bound](auto value) { return value < bound; });
+	};
+	auto const ascending = [](auto array, std::uint64_t last) {
+		return !array.empty() && array.front() == 0 && array.back() == last
+		    && std::is_sorted(array.begin(), array.end());
+	};
+	if (!index.word_offsets.empty() && !ascending(index.word_offsets, section.text_bytes)) return false;
+	if (section.buckets == 0 ? !index.bucket_words.empty() : !ascending(index.bucket_offsets, index.bucket_words.size())) {
+		return false;
+	}
+	if (!below(index.bucket_words, count) || !below(index.word_buckets, section.buckets)) return false;
+	// A displacement with direct_slot set names a slot outright; find takes any other one
+	// modulo the number of slots, and falls back to find_sorted when there are none.
+	for (auto displacement : index.hash_displacements) {
+		if ((displacement & direct_slot) && (displacement & ~direct_slot) >= count) return false;
+	}
+	if (!below(index.hash_slots, count)) return false;
+	if (section.packed_count != 0 && section.packed_count != count) return false;
+	return below(index.components, count);
+}
+} // namespace
+
+auto word_ladder::map_lexicon(const std::string &path) -> std::vector<neighbour_index> {
+	int fd = ::open(path.c_str(), O_RDONLY);
+	if (fd < 0) {
+		throw std::runtime_error("Cannot open compiled lexicon: " + path);
+	}
+	struct stat info {};
+	if (::fstat(fd, &info) != 0 || static_cast<std::size_t>(info.st_size) < sizeof(lexicon_header)) {
+		::close(fd);
+		throw std::runtime_error("Not a compiled lexicon: " + path);
+	}
+	auto const bytes = static_cast<std::size_t>(info.st_size);
+	void *mapping = ::mmap(nullptr, bytes, PROT_READ, MAP_PRIVATE, fd, 0);
+	::close(fd);
+	if (mapping == MAP_FAILED) {
+		throw std::runtime_error("Cannot map compiled lexicon: " + path);
+	}
+	auto storage = std::shared_ptr<const void>(mapping, [bytes](const void *p) {
+		::munmap(const_cast<void*>(p), bytes);
+	});
+	auto const *base = static_cast<const char*>(mapping);
+
+	lexicon_header header {};
+	std::memcpy(&header, base, sizeof(header));
+	if (!std::equal(std::begin(lexicon_magic), std::end(lexicon_magic), header.magic)
+	    || header.lengths > (bytes - sizeof(header)) / sizeof(lexicon_section)) {
+		throw std::runtime_error("Not a compiled lexicon: " + path);
+	}
+
+	// Views an array of count elements at offset, after checking it lies inside the file.
+	auto view = [&]<typename T>(std::uint64_t offset, std::uint64_t count, const T*) {
+		if (offset % alignof(T) != 0 || offset > bytes || count > (bytes - offset) / sizeof(T)) {
+			throw std::runtime_error("Corrupt compiled lexicon: " + path);
+		}
+		return std::span<const T>(reinterpret_cast<const T*>(base + offset), static_cast<std::size_t>(count));
+	};
+	std::vector<neighbour_index> indices(static_cast<std::size_t>(header.lengths));
+	for (std::size_t length = 0; length < indices.size(); ++length) {
+		lexicon_section section {};
+		std::memcpy(&section, base + sizeof(header) + length * sizeof(section), sizeof(section));
+		auto &index = indices[length];
+		auto const cells = section.count * length;
+		index.length = length;
+		index.text = view(section.text, section.text_bytes, static_cast<const char*>(nullptr));
+		index.word_offsets = view(section.word_offsets, section.word_offsets_count, static_cast<const std::uint32_t*>(nullptr));
+		if (index.word_offsets.empty() ? section.text_bytes != cells
+		        : index.word_offsets.size() != section.count + 1 || index.word_offsets.back() != section.text_bytes) {
+			throw std::runtime_error("Corrupt compiled lexicon: " + path);
+		}
+		index.bucket_offsets = view(section.bucket_offsets, section.buckets == 0 ? 0 : section.buckets + 1, static_cast<const std::uint32_t*>(nullptr));
+		index.bucket_words = view(section.bucket_words, cells, static_cast<const word_id*>(nullptr));
+		index.word_buckets = view(section.word_buckets, cells, static_cast<const std::uint32_t*>(nullptr));
+		index.hash_displacements = view(section.hash_displacements, section.displacements, static_cast<const std::uint32_t*>(nullptr));
+		index.hash_slots = view(section.hash_slots, section.count, static_cast<const word_id*>(nullptr));
+		index.packed = view(section.packed, section.packed_count, static_cast<const std::uint64_t*>(nullptr));
+		index.components = view(section.components, section.count, static_cast<const std::uint32_t*>(nullptr));
+		index.storage = storage;
+		if (!consistent(index, section)) {
+			throw std::runtime_error("Corrupt compiled lexicon: " + path);
+		}
+	}
+	return indices;
+}
+
+word_ladder::scratch_arena::scratch_arena(std::size_t capacity)
+: _buffer(capacity) {
+	_arena.emplace(_buffer.data(), _buffer.size(), &_spill);
+}
+
+void word_ladder::scratch_arena::reset() {
+	if (_spill.bytes == 0) {
+		_arena->release();
+		return;
+	}
+	// Destroying the arena hands the spilled blocks back to the heap.
+	_arena.reset();
+	_buffer.resize(_buffer.size() + _spill.bytes);
+	_spill.bytes = 0;
+	_arena.emplace(_buffer.data(), _buffer.size(), &_spill);
+}
+
+auto word_ladder::scratch_arena::capacity() const noexcept -> std::size_t {
+	return _buffer.size();
+}
+
+auto word_ladder::scratch_arena::spilled() const noexcept -> std::size_t {
+	return _spill.bytes;
+}
+
+auto word_ladder::scratch_arena::do_allocate(std::size_t bytes, std::size_t alignment) -> void* {
+	return _arena->allocate(bytes, alignment);
+}
+
+void word_ladder::scratch_arena::do_deallocate(void *p, std::size_t bytes, std::size_t alignment) {
+	_arena->deallocate(p, bytes, alignment);
+}
+
+auto word_ladder::scratch_arena::do_is_equal(const std::pmr::memory_resource &other) const noexcept -> bool {
+	return this == &other;
+}
+
+auto word_ladder::scratch_arena::spill_resource::do_allocate(std::size_t bytes, std::size_t alignment) -> void* {
+	this->bytes += bytes;
+	return std::pmr::new_delete_resource()->allocate(bytes, alignment);
+}
+
+void word_ladder::scratch_arena::spill_resource::do_deallocate(void *p, std::size_t bytes, std::size_t alignment) {
+	std::pmr::new_delete_resource()->deallocate(p, bytes, alignment);
+}
+
+auto word_ladder::scratch_arena::spill_resource::do_is_equal(const std::pmr::memory_resource &other) const noexcept
+    -> bool {
+	return this == &other;
+}
+
+void word_ladder::word_bitset::reset(std::size_t words) {
+	_size = words;
+	_bits.assign((words + 63) / 64, 0);
+}
+
+void word_ladder::word_bitset::clear() noexcept {
+	std::fill(_bits.begin(), _bits.end(), 0);
+}
+
+auto word_ladder::word_bitset::size() const noexcept -> std::size_t {
+	return _size;
+}
+
+auto word_ladder::word_bitset::blocks() const noexcept -> std::size_t {
+	return _bits.size();
+}
+
+void word_ladder::swap_set_with_smaller_len(search_state &state) {
+	bool const swap_ends = state.policy == direction_policy::expansion_cost
+	    ? state.begin_cost > state.end_cost
+	    : state.begin_size > state.end_size;
+	if (swap_ends) {
+        swap(state.begin_set, state.end_set);
+        std::swap(state.begin_size, state.end_size);
+        std::swap(state.begin_cost, state.end_cost);
+        state.reversed = !state.reversed;
     }
+	auto &step = state.steps.emplace_back();
+	step.expanded_from_side = !state.reversed;
+	step.from_size = state.reversed ? state.end_size : state.begin_size;
+	step.to_size = state.reversed ? state.begin_size : state.end_size;
+	step.from_cost = state.reversed ? state.end_cost : state.begin_cost;
+	step.to_cost = state.reversed ? state.begin_cost : state.end_cost;
+}
+
+void word_ladder::not_find_end_word(search_state &state, word_id cur_word, word_id word) {
+	if (!state.next_level.test(cur_word)) {
+		state.next_level.set(cur_word);
+		++state.next_size;
+		(state.reversed ? state.to_reached : state.from_reached).set(cur_word);
+		state.visited.push_back(cur_word);
+	}
+	state.parents[cur_word].push_back(word);
+}
+
+void word_ladder::found_end_word(search_state &state, word_id cur_word, word_id word) {
+	if (state.reversed) {
+		state.meetings.emplace_back(cur_word, word);
+	} else {
+		state.meetings.emplace_back(word, cur_word);
+	}
 }
 
-void word_ladder::erase_word(
-    std::unordered_set<std::string_view> &dict, 
-    const std::unordered_set<std::string> &begin_set
+namespace {
+// Handle one neighbour of a frontier word during a serial expansion.
+void visit_neighbour(word_ladder::search_state &state, word_ladder::word_id word, word_ladder::word_id neighbour) {
+	const auto &begin_reached = state.reversed ? state.to_reached : state.from_reached;
+	const auto &end_reached = state.reversed ? state.from_reached : state.to_reached;
+	if (end_reached.test(neighbour)) {
+		// The other end only ever reaches words next to its own frontier, so any word it
+		// reached that is adjacent to this frontier is in end_set.
+		state.found = true;
+		word_ladder::found_end_word(state, neighbour, word);
+	} else if (!begin_reached.test(neighbour) || state.next_level.test(neighbour)) {
+		// Unreached, or already in the level being built: one more shortest way into it.
+		word_ladder::not_find_end_word(state, neighbour, word);
+	}
+}
+
+// Codes scanned per block of walk_packed_neighbours; small enough for the hit flags to
+// stay in L1, large enough for the vectorised loop to dominate.
+constexpr std::size_t packed_block = 256;
+
+// Baseline x86-64 has no 64-bit vector compares, so where the toolchain can pick a function
+// clone at load time the scan is also built for AVX2 and the CPU decides which one runs.
+#if defined(__GNUC__) && defined(__x86_64__) && defined(__linux__)
+#define WORD_LADDER_SIMD_CLONES __attribute__((target_clones("avx2", "default")))
+#else
+#define WORD_LADDER_SIMD_CLONES
+#endif
+
+// hits[j] = 1 if codes[j] differs from code in exactly one of the lanes, else 0.
+// Everything is 64 bits wide and branch free so the loop vectorises.
+WORD_LADDER_SIMD_CLONES
+void scan_packed_block(
+    const std::uint64_t *codes,
+    std::size_t count,
+    std::uint64_t code,
+    std::uint64_t lanes,
+    std::uint64_t *hits
 ) {
-	for (const auto &word : begin_set) {
-        dict.erase(word);
-    }
+	for (std::size_t j = 0; j < count; ++j) {
+		auto const x = codes[j] ^ code;
+		auto const differ = (x | x >> 1 | x >> 2 | x >> 3 | x >> 4) & lanes;
+		hits[j] = static_cast<std::uint64_t>(differ != 0) & static_cast<std::uint64_t>((differ & (differ - 1)) == 0);
+	}
 }
 
-void word_ladder::not_find_end_word(
-    std::unordered_set<std::string> &next_level, 
-    std::unordered_map<std::string, std::vector<std::vector<std::string>>> &begin_map, 
-    const std::string &cur_word,
-    const std::string &word
+// Call visit(neighbour) for every neighbour of word, found the way mode says.
+template <typename Visit>
+void for_each_neighbour(
+    const word_ladder::neighbour_index &index,
+    word_ladder::expansion_mode mode,
+    word_ladder::word_id word,
+    Visit visit
 ) {
-	next_level.insert(cur_word);
-    for (auto path : begin_map[word]) {
-        path.push_back(cur_word);
-        begin_map[cur_word].push_back(path);
-    }
+	if (mode == word_ladder::expansion_mode::packed_scan && !index.packed.empty()) {
+		// Bit 0 of every 5-bit lane in use.
+		std::uint64_t lanes = 0;
+		for (std::size_t i = 0; i < index.length; ++i) {
+			lanes |= std::uint64_t {1} << (5 * i);
+		}
+		std::uint64_t hits[packed_block];
+		for (std::size_t first = 0; first < index.packed.size(); first += packed_block) {
+			auto const count = std::min(packed_block, index.packed.size() - first);
+			scan_packed_block(index.packed.data() + first, count, index.packed[word], lanes, hits);
+			for (std::size_t j = 0; j < count; ++j) {
+				if (hits[j]) visit(static_cast<word_ladder::word_id>(first + j));
+			}
+		}
+		return;
+	}
+	for (std::size_t i = 0; i < index.length; ++i) {
+		for (auto neighbour : index.bucket(word, i)) {
+			if (neighbour != word) visit(neighbour);
+		}
+	}
 }
+} // namespace
 
-void word_ladder::found_end_word(
-    std::unordered_map<std::string, std::vector<std::vector<std::string>>> &begin_map,
-    std::unordered_map<std::string, std::vector<std::vector<std::string>>> &end_map,
-    const bool &reversed,
-    const std::string &cur_word,
-    const std::string &word,
-    std::vector<std::vector<std::string>> &ret
+void word_ladder::walk_neighbour_bucket(
+    const neighbour_index &index,
+    search_state &state,
+    word_id word,
+    std::size_t pos
 ) {
-	for (auto &path1 : begin_map[word]) {
-        for (auto &path2 : end_map[cur_word]) {
-            if (reversed) {
-                std::vector<std::string> combined_path = path2;
-                combined_path.insert(combined_path.end(), path1.rbegin(), path1.rend());
-                ret.push_back(combined_path);
-            } else {
-                std::vector<std::string> combined_path = path1;
-                combined_path.insert(combined_path.end(), path2.rbegin(), path2.rend());
-                ret.push_back(combined_path);
-            }
-        }
-    }
+	for (auto neighbour : index.bucket(word, pos)) {
+		if (neighbour != word) visit_neighbour(state, word, neighbour);
+	}
 }
 
-void word_ladder::sub_a_z_letter(
-    std::unordered_set<std::string> &end_set,
-    std::unordered_map<std::string, std::vector<std::vector<std::string>>> &begin_map,
-    std::unordered_map<std::string, std::vector<std::vector<std::string>>> &end_map,
-    bool reversed,
-    bool &found,
-    std::vector<std::vector<std::string>> &ret,
-    std::string &cur_word,
-    std::string word,
-    std::size_t &i,
-    std::unordered_set<std::string> &next_level,
-    std::unordered_set<std::string_view> &dict
+void word_ladder::walk_packed_neighbours(
+    const neighbour_index &index,
+    search_state &state,
+    word_id word
 ) {
-	for (char ch = 'a'; ch <= 'z'; ++ch) {
-        if (cur_word[i] == ch) continue;
-        cur_word[i] = ch;
-        if (end_set.count(cur_word)) {
-            found = true;
-            found_end_word(begin_map, end_map, reversed, cur_word, word, ret);
-        } else if (dict.count(cur_word)) {
-            not_find_end_word(next_level, begin_map, cur_word, word);
-        }
-    }
+	for_each_neighbour(index, expansion_mode::packed_scan, word, [&](word_id neighbour) {
+		visit_neighbour(state, word, neighbour);
+	});
 }
 
-void word_ladder::two_end_bfs(
-    std::unordered_set<std::string> &begin_set,
-    std::unordered_set<std::string> &end_set,
-    std::unordered_map<std::string, std::vector<std::vector<std::string>>> &begin_map,
-    std::unordered_map<std::string, std::vector<std::vector<std::string>>> &end_map,
-    bool reversed,
-    std::vector<std::vector<std::string>> &ret,
-    std::unordered_set<std::string_view> dict,
-    std::size_t length,
-    bool found) {
-	while (!begin_set.empty() && !end_set.empty() && !found) {
-        swap_set_with_smaller_len(begin_set, end_set, reversed, begin_map, end_map);
-        std::unordered_set<std::string> next_level;
-        erase_word(dict, begin_set);
-        for (const auto &word : begin_set) {
-            std::string cur_word = word;
-            for (std::size_t i = 0; i < length; ++i) {
-                char original_char = cur_word[i];
-                sub_a_z_letter(end_set, begin_map, end_map, reversed, found, ret, cur_word, word, i, next_level, dict);
-                cur_word[i] = original_char;
-            }
+namespace {
+// start_search for any index with size() and degree().
+template <typename Index>
+void reset_search(const Index &index, word_ladder::search_state &state, word_ladder::word_id from, word_ladder::word_id to) {
+	if (state.parents.size() != index.size()) {
+		state.parents.clear();
+		state.parents.reserve(index.size());
+		for (std::size_t id = 0; id < index.size(); ++id) {
+			state.parents.emplace_back(state.arena.get());
+		}
+		state.local.assign(index.size(), UINT32_MAX);
+		for (auto *set : {&state.begin_set, &state.end_set, &state.next_level, &state.from_reached, &state.to_reached}) {
+			set->reset(index.size());
+		}
+	} else {
+		// Drop the lists outright rather than clear them: their memory goes with the arena.
+		for (auto word : state.visited) {
+			state.parents[word] = std::pmr::vector<word_ladder::word_id>(state.arena.get());
+		}
+		for (auto *set : {&state.begin_set, &state.end_set, &state.next_level, &state.from_reached, &state.to_reached}) {
+			set->clear();
+		}
+	}
+	state.arena->reset();
+	state.visited.clear();
+	state.meetings.clear();
+	state.reversed = false;
+	state.found = false;
+	state.begin_set.set(from);
+	state.end_set.set(to);
+	state.begin_size = 1;
+	state.end_size = 1;
+	state.next_size = 0;
+	state.begin_cost = index.degree(from);
+	state.end_cost = index.degree(to);
+	state.steps.clear();
+	state.from_reached.set(from);
+	state.to_reached.set(to);
+	state.visited.push_back(from);
+	state.visited.push_back(to);
+}
+} // namespace
+
+void word_ladder::start_search(const neighbour_index &index, search_state &state, word_id from, word_id to) {
+	reset_search(index, state, from, to);
+}
+
+void word_ladder::start_search(const edit_index &index, search_state &state, word_id from, word_id to) {
+	reset_search(index, state, from, to);
+}
+
+// A fixed set of threads that each run their slice of a job, then wait for the next one.
+class word_ladder::expand_pool {
+ public:
+	// Starts threads - 1 workers; the thread calling run takes slice 0.
+	explicit expand_pool(std::size_t threads) {
+		_workers.reserve(threads - 1);
+		for (std::size_t t = 1; t < threads; ++t) {
+			_workers.emplace_back([this, t] { work(t); });
+		}
+	}
+
+	~expand_pool() {
+		{
+			std::lock_guard lock(_mutex);
+			_stopping = true;
+		}
+		_start.notify_all();
+		// _workers is the last member, so the threads are joined before anything they use goes.
+	}
+
+	auto threads() const noexcept -> std::size_t {
+		return _workers.size() + 1;
+	}
+
+	// Run job(t) for every slice t, returning once all of them are done.
+	void run(const std::function<void(std::size_t)> &job) {
+		{
+			std::lock_guard lock(_mutex);
+			_job = &job;
+			_pending = _workers.size();
+			++_generation;
+		}
+		_start.notify_all();
+		job(0);
+		std::unique_lock lock(_mutex);
+		_done.wait(lock, [this] { return _pending == 0; });
+		_job = nullptr;
+	}
+
+ private:
+	void work(std::size_t t) {
+		std::uint64_t seen = 0;
+		std::unique_lock lock(_mutex);
+		while (true) {
+			_start.wait(lock, [&] { return _stopping || _generation != seen; });
+			if (_stopping) return;
+			seen = _generation;
+			const auto *job = _job;
+			lock.unlock();
+			(*job)(t);
+			lock.lock();
+			if (--_pending == 0) _done.notify_one();
+		}
+	}
+
+	std::mutex _mutex;
+	std::condition_variable _start;
+	std::condition_variable _done;
+	const std::function<void(std::size_t)> *_job = nullptr;
+	std::uint64_t _generation = 0;
+	std::size_t _pending = 0;
+	bool _stopping = false;
+	std::vector<std::jthread> _workers;
+};
+
+void word_ladder::parallel_expand_level(const neighbour_index &index, search_state &state) {
+	auto const threads = state.expand_threads;
+	state.thread_edges.resize(threads);
+	state.thread_meetings.resize(threads);
+	auto expand_slice = [&](std::size_t t) {
+		auto &edges = state.thread_edges[t];
+		auto &meetings = state.thread_meetings[t];
+		edges.clear();
+		meetings.clear();
+		const auto &begin_reached = state.reversed ? state.to_reached : state.from_reached;
+		const auto &end_reached = state.reversed ? state.from_reached : state.to_reached;
+		auto const first = t * state.begin_set.blocks() / threads;
+		auto const last = (t + 1) * state.begin_set.blocks() / threads;
+		state.begin_set.for_each([&](word_id word) {
+			for_each_neighbour(index, state.expansion, word, [&](word_id neighbour) {
+				if (end_reached.test(neighbour)) {
+					meetings.emplace_back(word, neighbour);
+				} else if (!begin_reached.test(neighbour)) {
+					edges.emplace_back(word, neighbour);
+				}
+			});
+		}, first, last);
+	};
+	if (!state.workers || state.workers->threads() != threads) {
+		state.workers = std::make_shared<expand_pool>(threads);
+	}
+	state.workers->run(expand_slice);
+
+	// Nothing in the level being built was marked while the slices were scanned, so an
+	// unreached neighbour found twice is simply given a second parent here.
+	for (std::size_t t = 0; t < threads; ++t) {
+		for (auto [word, neighbour] : state.thread_edges[t]) {
+			not_find_end_word(state, neighbour, word);
+		}
+		for (auto [word, neighbour] : state.thread_meetings[t]) {
+			state.found = true;
+			found_end_word(state, neighbour, word);
+		}
+	}
+}
+
+void word_ladder::two_end_bfs(const neighbour_index &index, search_state &state) {
+	while (state.begin_size != 0 && state.end_size != 0 && !state.found) {
+        swap_set_with_smaller_len(state);
+        state.next_level.clear();
+        state.next_size = 0;
+        if (state.expand_threads > 1 && state.begin_size >= state.parallel_min_frontier) {
+            parallel_expand_level(index, state);
+        } else if (state.expansion == expansion_mode::packed_scan && !index.packed.empty()) {
+            state.begin_set.for_each([&](word_id word) {
+                walk_packed_neighbours(index, state, word);
+            });
+        } else {
+            state.begin_set.for_each([&](word_id word) {
+                for (std::size_t i = 0; i < index.length; ++i) {
+                    walk_neighbour_bucket(index, state, word, i);
+                }
+            });
         }
-        begin_set = next_level;
+        swap(state.begin_set, state.next_level);
+        state.begin_size = state.next_size;
+        state.begin_cost = 0;
+        state.begin_set.for_each([&](word_id word) {
+            state.begin_cost += index.degree(word);
+        });
     }
 }
 
+auto word_ladder::substitution_costs::cost(char32_t from, char32_t to) const -> double {
+	auto it = letters.find({from, to});
+	return it == letters.end() ? default_cost : it->second;
+}
+
+auto word_ladder::substitution_costs::cheapest() const noexcept -> double {
+	auto cheapest = default_cost;
+	for (const auto &[letters, cost] : letters) {
+		cheapest = std::min(cheapest, cost);
+	}
+	return cheapest;
+}
+
+auto word_ladder::position_alphabets(const neighbour_index &index) -> std::vector<std::vector<char32_t>> {
+	std::vector<std::vector<char32_t>> alphabets(index.length);
+	if (index.word_offsets.empty()) {
+		// Every code point is a single byte, so mark which bytes occur at each position.
+		std::vector<std::array<bool, 256>> seen(index.length);
+		for (word_id id = 0; id < index.size(); ++id) {
+			auto const word = index.word(id);
+			for (std::size_t pos = 0; pos < index.length; ++pos) {
+				seen[pos][static_cast<unsigned char>(word[pos])] = true;
+			}
+		}
+		for (std::size_t pos = 0; pos < index.length; ++pos) {
+			for (char32_t letter = 0; letter < 256; ++letter) {
+				if (seen[pos][letter]) alphabets[pos].push_back(letter);
+			}
+		}
+		return alphabets;
+	}
+	std::vector<std::size_t> starts;
+	for (word_id id = 0; id < index.size(); ++id) {
+		auto const word = index.word(id);
+		code_point_starts(word, starts);
+		for (std::size_t pos = 0; pos < index.length; ++pos) {
+			alphabets[pos].push_back(decode(word.substr(starts[pos], starts[pos + 1] - starts[pos])));
+		}
+	}
+	for (auto &alphabet : alphabets) {
+		std::sort(alphabet.begin(), alphabet.end());
+		alphabet.erase(std::unique(alphabet.begin(), alphabet.end()), alphabet.end());
+	}
+	return alphabets;
+}
+
+namespace {
+// The cheapest substitution any word of index can make: listed costs only count at the
+// positions where both of their letters occur, and the default cost only where some pair
+// of letters occurring there is not listed.
+auto cheapest_step(
+    std::span<const std::vector<char32_t>> alphabets,
+    const word_ladder::substitution_costs &costs
+) -> double {
+	if (costs.letters.empty()) return costs.default_cost;
+	auto cheapest = std::numeric_limits<double>::infinity();
+	for (const auto &alphabet : alphabets) {
+		auto occurs = [&](char32_t letter) {
+			return std::binary_search(alphabet.begin(), alphabet.end(), letter);
+		};
+		std::size_t listed = 0;
+		for (const auto &[letters, cost] : costs.letters) {
+			if (letters.first != letters.second && occurs(letters.first) && occurs(letters.second)) {
+				cheapest = std::min(cheapest, cost);
+				++listed;
+			}
+		}
+		if (alphabet.size() > 1 && listed < alphabet.size() * (alphabet.size() - 1)) {
+			cheapest = std::min(cheapest, costs.default_cost);
+		}
+	}
+	return cheapest == std::numeric_limits<double>::infinity() ? costs.cheapest() : cheapest;
+}
+} // namespace
+
+auto word_ladder::best_ladder(
+	const std::string &from,
+	const std::string &to,
+	const neighbour_index &index,
+	const substitution_costs &costs
+) -> weighted_ladder {
+	if (costs.letters.empty()) return best_ladder(from, to, index, costs, {});
+	return best_ladder(from, to, index, costs, position_alphabets(index));
+}
+
+auto word_ladder::best_ladder(
+	const std::string &from,
+	const std::string &to,
+	const neighbour_index &index,
+	const substitution_costs &costs,
+	std::span<const std::vector<char32_t>> alphabets
+) -> weighted_ladder {
+	weighted_ladder ret;
+	auto from_id = index.find(from);
+	auto to_id = index.find(to);
+	if (!from_id || !to_id || !index.connected(*from_id, *to_id)) {
+		return ret;
+	}
+
+	auto const cheapest = cheapest_step(alphabets, costs);
+	auto const target = index.word(*to_id);
+	// An index without word_offsets is plain ASCII, where bytes are code points.
+	bool const ascii = index.word_offsets.empty();
+	std::vector<std::size_t> target_starts;
+	std::vector<std::size_t> starts;
+	code_point_starts(target, target_starts);
+	auto letters_left = [&](word_id id) {
+		auto const word = index.word(id);
+		std::size_t differ = 0;
+		if (ascii) {
+			for (std::size_t pos = 0; pos < index.length; ++pos) {
+				differ += word[pos] != target[pos];
+			}
+			return differ;
+		}
+		code_point_starts(word, starts);
+		for (std::size_t pos = 0; pos < index.length; ++pos) {
+			differ += word.substr(starts[pos], starts[pos + 1] - starts[pos])
+			    != target.substr(target_starts[pos], target_starts[pos + 1] - target_starts[pos]);
+		}
+		return differ;
+	};
+	auto letter = [&](word_id id, std::size_t pos) -> char32_t {
+		if (ascii) return static_cast<unsigned char>(index.word(id)[pos]);
+		return code_point_at(index.word(id), pos);
+	};
+
+	// Open entries are (estimated total, letters left, word); stale ones are skipped when popped.
+	using entry = std::tuple<double, std::size_t, word_id>;
+	std::priority_queue<entry, std::vector<entry>, std::greater<>> open;
+	std::vector<double> cost(index.size(), std::numeric_limits<double>::infinity());
+	std::vector<word_id> parent(index.size(), UINT32_MAX);
+	word_bitset closed;
+	closed.reset(index.size());
+	cost[*from_id] = 0;
+	open.emplace(static_cast<double>(letters_left(*from_id)) * cheapest, letters_left(*from_id), *from_id);
+	while (!open.empty()) {
+		auto [estimate, left, word] = open.top();
+		open.pop();
+		if (closed.test(word)) continue;
+		closed.set(word);
+		++ret.expanded;
+		if (word == *to_id) break;
+
+		for (std::size_t pos = 0; pos < index.length; ++pos) {
+			for (auto neighbour : index.bucket(word, pos)) {
+				if (neighbour == word || closed.test(neighbour)) continue;
+				auto const through = cost[word] + costs.cost(letter(word, pos), letter(neighbour, pos));
+				if (through >= cost[neighbour]) continue;
+				cost[neighbour] = through;
+				parent[neighbour] = word;
+				auto const remaining = letters_left(neighbour);
+				open.emplace(through + static_cast<double>(remaining) * cheapest, remaining, neighbour);
+			}
+		}
+	}
+	if (!closed.test(*to_id)) {
+		return ret;
+	}
+
+	ret.cost = cost[*to_id];
+	for (auto word = *to_id; word != UINT32_MAX; word = parent[word]) {
+		ret.words.emplace_back(index.word(word));
+	}
+	std::reverse(ret.words.begin(), ret.words.end());
+	return ret;
+}
+
+auto word_ladder::edit_index::size() const noexcept -> std::size_t {
+	return words.size();
+}
+
+auto word_ladder::edit_index::word(word_id id) const noexcept -> std::string_view {
+	return words[id];
+}
+
+auto word_ladder::edit_index::find(std::string_view word) const -> std::optional<word_id> {
+	auto it = std::lower_bound(words.begin(), words.end(), word);
+	if (it == words.end() || *it != word) return std::nullopt;
+	return static_cast<word_id>(it - words.begin());
+}
+
+auto word_ladder::edit_index::neighbours_of(word_id id) const noexcept -> std::span<const word_id> {
+	return std::span<const word_id>(neighbours).subspan(offsets[id], offsets[id + 1] - offsets[id]);
+}
+
+auto word_ladder::edit_index::degree(word_id id) const noexcept -> std::size_t {
+	return offsets[id + 1] - offsets[id];
+}
+
+auto word_ladder::build_edit_index(const std::unordered_set<std::string> &lexicon) -> edit_index {
+	edit_index index;
+	index.words = std::vector<std::string>(lexicon.begin(), lexicon.end());
+	std::sort(index.words.begin(), index.words.end());
+
+	// Every word under each of its one letter deletions, with the deleted position.
+	std::unordered_map<std::string, std::vector<std::pair<word_id, std::uint32_t>>> deletions;
+	std::size_t letters = 0;
+	for (const auto &word : index.words) {
+		letters += word.size();
+	}
+	deletions.reserve(letters);
+	std::vector<std::size_t> starts;
+	for (std::size_t id = 0; id < index.words.size(); ++id) {
+		const auto &word = index.words[id];
+		code_point_starts(word, starts);
+		for (std::size_t pos = 0; pos + 1 < starts.size(); ++pos) {
+			auto key = word.substr(0, starts[pos]) + word.substr(starts[pos + 1]);
+			deletions[std::move(key)].emplace_back(static_cast<word_id>(id), static_cast<std::uint32_t>(pos));
+		}
+	}
+
+	std::vector<std::vector<word_id>> adjacent(index.words.size());
+	for (const auto &[key, filed] : deletions) {
+		for (std::size_t i = 0; i < filed.size(); ++i) {
+			for (std::size_t j = i + 1; j < filed.size(); ++j) {
+				if (filed[i].second == filed[j].second) {
+					adjacent[filed[i].first].push_back(filed[j].first);
+					adjacent[filed[j].first].push_back(filed[i].first);
+				}
+			}
+		}
+		if (auto shorter = index.find(key)) {
+			for (auto [longer, pos] : filed) {
+				adjacent[*shorter].push_back(longer);
+				adjacent[longer].push_back(*shorter);
+			}
+		}
+	}
+
+	// A word like "aab" is filed twice under "ab", so lists can hold repeats.
+	index.offsets.reserve(index.words.size() + 1);
+	index.offsets.push_back(0);
+	for (auto &list : adjacent) {
+		std::sort(list.begin(), list.end());
+		list.erase(std::unique(list.begin(), list.end()), list.end());
+		index.neighbours.insert(index.neighbours.end(), list.begin(), list.end());
+		index.offsets.push_back(static_cast<std::uint32_t>(index.neighbours.size()));
+	}
+
+	// Label components by BFS, in id order, so labels are numbered from 0 like label_components.
+	index.components.assign(index.words.size(), UINT32_MAX);
+	std::uint32_t labels = 0;
+	std::vector<word_id> queue;
+	for (std::size_t id = 0; id < index.words.size(); ++id) {
+		if (index.components[id] != UINT32_MAX) continue;
+		index.components[id] = labels;
+		queue.assign(1, static_cast<word_id>(id));
+		for (std::size_t head = 0; head < queue.size(); ++head) {
+			for (auto neighbour : index.neighbours_of(queue[head])) {
+				if (index.components[neighbour] != UINT32_MAX) continue;
+				index.components[neighbour] = labels;
+				queue.push_back(neighbour);
+			}
+		}
+		++labels;
+	}
+	return index;
+}
+
+void word_ladder::two_end_bfs(const edit_index &index, search_state &state) {
+	while (state.begin_size != 0 && state.end_size != 0 && !state.found) {
+		swap_set_with_smaller_len(state);
+		state.next_level.clear();
+		state.next_size = 0;
+		state.begin_set.for_each([&](word_id word) {
+			for (auto neighbour : index.neighbours_of(word)) {
+				visit_neighbour(state, word, neighbour);
+			}
+		});
+		swap(state.begin_set, state.next_level);
+		state.begin_size = state.next_size;
+		state.begin_cost = 0;
+		state.begin_set.for_each([&](word_id word) {
+			state.begin_cost += index.degree(word);
+		});
+	}
+}
+
+auto word_ladder::stream_edit_ladders(
+	const std::string &from,
+	const std::string &to,
+	const edit_index &index
+) -> ladder_stream {
+	auto from_id = index.find(from);
+	auto to_id = index.find(to);
+	// A word is no ladder to itself, as in stream_ladders.
+	if (!from_id || !to_id || *from_id == *to_id || index.components[*from_id] != index.components[*to_id]) {
+		return {};
+	}
+
+	search_state state;
+	start_search(index, state, *from_id, *to_id);
+	two_end_bfs(index, state);
+	if (state.meetings.empty()) {
+		return {};
+	}
+
+	ladder_dag dag;
+	build_ladder_dag(state, dag);
+	return ladder_stream([&index](word_id id) { return index.word(id); }, std::move(dag));
+}
+
+auto word_ladder::generate_edit_ladders(
+	const std::string &from,
+	const std::string &to,
+	const edit_index &index
+) -> std::vector<std::vector<std::string>> {
+	std::vector<std::vector<std::string>> ret;
+	for (const auto &ladder : stream_edit_ladders(from, to, index)) {
+		ret.push_back(ladder);
+	}
+	return ret;
+}
+
+auto word_ladder::generate_edit_ladders(
+	const std::string &from,
+	const std::string &to,
+	const std::unordered_set<std::string> &lexicon
+) -> std::vector<std::vector<std::string>> {
+	return generate_edit_ladders(from, to, build_edit_index(lexicon));
+}
+
+auto word_ladder::landmark_index::lower_bound(word_id from, word_id to) const noexcept -> std::size_t {
+	std::size_t bound = 0;
+	for (std::size_t l = 0; l < landmarks.size(); ++l) {
+		auto const a = distances[l * words + from];
+		auto const b = distances[l * words + to];
+		if (a == unreachable || b == unreachable) continue;
+		bound = std::max<std::size_t>(bound, a > b ? a - b : b - a);
+	}
+	return bound;
+}
+
+auto word_ladder::landmark_index::upper_bound(word_id from, word_id to) const noexcept -> std::size_t {
+	std::size_t bound = SIZE_MAX;
+	for (std::size_t l = 0; l < landmarks.size(); ++l) {
+		auto const a = distances[l * words + from];
+		auto const b = distances[l * words + to];
+		if (a == unreachable || b == unreachable) continue;
+		bound = std::min<std::size_t>(bound, std::size_t {a} + b);
+	}
+	return bound;
+}
+
+auto word_ladder::build_landmark_index(const neighbour_index &index, std::size_t count) -> landmark_index {
+	landmark_index landmarks;
+	landmarks.words = index.size();
+	if (landmarks.words == 0 || count == 0) return landmarks;
+
+	// The largest component, with the smallest label on ties. An index without components
+	// is treated as one component.
+	std::uint32_t largest = 0;
+	if (!index.components.empty()) {
+		std::vector<std::size_t> sizes;
+		for (auto label : index.components) {
+			if (label >= sizes.size()) sizes.resize(label + 1);
+			++sizes[label];
+		}
+		largest = static_cast<std::uint32_t>(std::max_element(sizes.begin(), sizes.end()) - sizes.begin());
+	}
+	auto const in_largest = [&](word_id id) {
+		return index.components.empty() || index.components[id] == largest;
+	};
+	std::optional<word_id> first;
+	for (word_id id = 0; id < landmarks.words; ++id) {
+		if (in_largest(id) && (!first || index.degree(id) > index.degree(*first))) first = id;
+	}
+	// Distance from each word to its nearest landmark so far, to pick the next one.
+	std::vector<std::uint16_t> nearest(landmarks.words, landmark_index::unreachable);
+	std::vector<word_id> queue;
+	auto next = *first;
+	while (landmarks.landmarks.size() < count) {
+		landmarks.landmarks.push_back(next);
+		auto const offset = landmarks.distances.size();
+		landmarks.distances.resize(offset + landmarks.words, landmark_index::unreachable);
+		auto *dist = landmarks.distances.data() + offset;
+		dist[next] = 0;
+		queue.assign(1, next);
+		for (std::size_t head = 0; head < queue.size(); ++head) {
+			auto const word = queue[head];
+			for (std::size_t pos = 0; pos < index.length; ++pos) {
+				for (auto neighbour : index.bucket(word, pos)) {
+					if (dist[neighbour] != landmark_index::unreachable) continue;
+					dist[neighbour] = static_cast<std::uint16_t>(dist[word] + 1);
+					queue.push_back(neighbour);
+				}
+			}
+		}
+
+		// The BFS reached exactly the component of the first landmark.
+		std::uint16_t furthest = 0;
+		for (auto word : queue) {
+			nearest[word] = std::min(nearest[word], dist[word]);
+			if (nearest[word] > furthest) {
+				furthest = nearest[word];
+				next = word;
+			}
+		}
+		if (furthest == 0) break;
+	}
+	return landmarks;
+}
+
+auto word_ladder::ladder_distance(
+    const neighbour_index &index,
+    search_state &state,
+    word_id from,
+    word_id to,
+    std::size_t limit
+) -> std::optional<std::size_t> {
+	if (from == to) return 0;
+	// Nothing is pushed to visited, so no parent links need clearing afterwards.
+	start_search(index, state, from, to);
+	state.visited.clear();
+	for (std::size_t steps = 1; steps <= limit && state.begin_size != 0 && state.end_size != 0; ++steps) {
+		swap_set_with_smaller_len(state);
+		auto &begin_reached = state.reversed ? state.to_reached : state.from_reached;
+		const auto &end_reached = state.reversed ? state.from_reached : state.to_reached;
+		state.next_level.clear();
+		state.next_size = 0;
+		state.begin_cost = 0;
+		bool met = false;
+		state.begin_set.for_each([&](word_id word) {
+			for (std::size_t pos = 0; pos < index.length && !met; ++pos) {
+				for (auto neighbour : index.bucket(word, pos)) {
+					if (end_reached.test(neighbour)) {
+						met = true;
+						break;
+					}
+					if (begin_reached.test(neighbour)) continue;
+					begin_reached.set(neighbour);
+					state.next_level.set(neighbour);
+					++state.next_size;
+					state.begin_cost += index.degree(neighbour);
+				}
+			}
+		});
+		if (met) return steps;
+		swap(state.begin_set, state.next_level);
+		state.begin_size = state.next_size;
+	}
+	return std::nullopt;
+}
+
+auto word_ladder::landmark_distance(
+    const neighbour_index &index,
+    const landmark_index &landmarks,
+    search_state &state,
+    word_id from,
+    word_id to,
+    std::size_t limit
+) -> std::optional<std::size_t> {
+	if (!index.connected(from, to)) return std::nullopt;
+	auto const lower = landmarks.lower_bound(from, to);
+	auto const upper = landmarks.upper_bound(from, to);
+	if (lower > limit) return std::nullopt;
+	if (lower == upper) return upper;
+	// Any ladder found below the upper bound is the shortest; if none is, the bound is exact.
+	if (auto steps = ladder_distance(index, state, from, to, std::min(limit, upper - 1))) {
+		return steps;
+	}
+	if (upper <= limit) return upper;
+	return std::nullopt;
+}
+
+void word_ladder::build_ladder_dag(search_state &state, ladder_dag &dag) {
+	dag.words.clear();
+	dag.offsets.clear();
+	dag.children.clear();
+	auto number = [&](word_id word) {
+		if (state.local[word] == UINT32_MAX) {
+			state.local[word] = static_cast<std::uint32_t>(dag.words.size());
+			dag.words.push_back(word);
+		}
+		return state.local[word];
+	};
+
+	// Edges as (local parent, child word), walked back from the meeting layer towards both
+	// ends. On the from side a parent comes before its child on the ladder, on the to side
+	// it comes after.
+	std::pmr::vector<std::pair<std::uint32_t, word_id>> edges(state.arena.get());
+	for (auto [from_side, to_side] : state.meetings) {
+		edges.emplace_back(number(from_side), to_side);
+		number(to_side);
+	}
+	for (std::size_t n = 0; n < dag.words.size(); ++n) {
+		auto word = dag.words[n];
+		bool const from_side = state.from_reached.test(word);
+		for (auto parent : state.parents[word]) {
+			if (from_side) {
+				edges.emplace_back(number(parent), word);
+			} else {
+				edges.emplace_back(static_cast<std::uint32_t>(n), parent);
+				number(parent);
+			}
+		}
+	}
+
+	// Ids follow word order, so sorting by (parent, child id) puts each child list in word order.
+	std::sort(edges.begin(), edges.end());
+	dag.offsets.assign(dag.words.size() + 1, 0);
+	dag.children.reserve(edges.size());
+	for (auto [parent, child] : edges) {
+		++dag.offsets[parent + 1];
+		dag.children.push_back(state.local[child]);
+	}
+	for (std::size_t n = 0; n < dag.words.size(); ++n) {
+		dag.offsets[n + 1] += dag.offsets[n];
+	}
+	for (std::size_t n = 0; n < dag.words.size(); ++n) {
+		if (state.parents[dag.words[n]].empty()) {
+			if (state.from_reached.test(dag.words[n])) {
+				dag.from = static_cast<std::uint32_t>(n);
+			} else {
+				dag.to = static_cast<std::uint32_t>(n);
+			}
+		}
+	}
+	for (auto word : dag.words) {
+		state.local[word] = UINT32_MAX;
+	}
+}
+
+word_ladder::ladder_stream::iterator::iterator(ladder_stream* stream) noexcept
+: _stream(stream) {}
+
+auto word_ladder::ladder_stream::iterator::operator*() const noexcept -> const std::vector<std::string>& {
+	return _stream->_current;
+}
+
+auto word_ladder::ladder_stream::iterator::operator->() const noexcept -> const std::vector<std::string>* {
+	return &_stream->_current;
+}
+
+auto word_ladder::ladder_stream::iterator::operator++() -> iterator& {
+	_stream->advance();
+	return *this;
+}
+
+auto word_ladder::ladder_stream::iterator::operator++(int) -> void {
+	++*this;
+}
+
+auto word_ladder::ladder_stream::iterator::at_end() const noexcept -> bool {
+	return _stream == nullptr || _stream->_done;
+}
+
+word_ladder::ladder_stream::ladder_stream(const neighbour_index& index, ladder_dag dag)
+: ladder_stream([&index](word_id id) { return index.word(id); }, std::move(dag)) {}
+
+word_ladder::ladder_stream::ladder_stream(std::function<std::string_view(word_id)> word, ladder_dag dag)
+: _word(std::move(word))
+, _dag(std::move(dag))
+, _done(false) {}
+
+auto word_ladder::ladder_stream::begin() -> iterator {
+	if (!_started) {
+		advance();
+	}
+	return iterator(this);
+}
+
+auto word_ladder::ladder_stream::end() const noexcept -> std::default_sentinel_t {
+	return std::default_sentinel;
+}
+
+auto word_ladder::ladder_stream::ids() const noexcept -> const std::vector<word_id>& {
+	return _ids;
+}
+
+auto word_ladder::ladder_stream::advance() -> bool {
+	if (_done) return false;
+	if (!_started) {
+		_started = true;
+		_path.assign(1, _dag.from);
+		_child.assign(1, _dag.offsets[_dag.from]);
+	} else {
+		// The last ladder ended at `to`, which has no children: backtrack from it.
+		_path.pop_back();
+		_child.pop_back();
+	}
+	// Children are sorted by id, i.e. by word, and every ladder has the same length,
+	// so depth first order is lexicographic order.
+	while (!_path.empty()) {
+		if (_child.back() == _dag.offsets[_path.back() + 1]) {
+			_path.pop_back();
+			_child.pop_back();
+			continue;
+		}
+		auto child = _dag.children[_child.back()++];
+		_path.push_back(child);
+		_child.push_back(_dag.offsets[child]);
+		if (child == _dag.to) {
+			_ids.resize(_path.size());
+			_current.resize(_path.size());
+			for (std::size_t i = 0; i < _path.size(); ++i) {
+				_ids[i] = _dag.words[_path[i]];
+				_current[i].assign(_word(_ids[i]));
+			}
+			return true;
+		}
+	}
+	_done = true;
+	return false;
+}
+
+auto word_ladder::stream_ladders(
+	const std::string &from,
+	const std::string &to,
+	const neighbour_index &index
+) -> ladder_stream {
+	no_stats stats;
+	return stream_ladders(from, to, index, stats);
+}
+
 auto word_ladder::generate(
 	const std::string &from,
 	const std::string &to,
 	const std::unordered_set<std::string> &lexicon
 ) -> std::vector<std::vector<std::string>> {
-	std::size_t length = from.size();
-    std::unordered_set<std::string_view> dict = filtered_dict(length, lexicon);
-
-    std::unordered_set<std::string> begin_set = {from}, end_set = {to};
-    std::unordered_map<std::string, std::vector<std::vector<std::string>>> begin_map, end_map;
-    begin_map[from] = {{from}};
-    end_map[to] = {{to}};
-    bool found = false, reversed = false;
-    std::vector<std::vector<std::string>> ret;
-    two_end_bfs(begin_set, end_set, begin_map, end_map, reversed, ret, dict, length, found);
-    std::sort(ret.begin(), ret.end(), less_comparator);
-    return ret;
-}
\ No newline at end of file
+	no_stats stats;
+	return generate(from, to, lexicon, stats);
+}
+
+auto word_ladder::generate(
+	const std::string &from,
+	const std::string &to,
+	const neighbour_index &index
+) -> std::vector<std::vector<std::string>> {
+	no_stats stats;
+	return generate(from, to, index, stats);
+}
+
+auto word_ladder::stream_ladders(
+	const std::string &from,
+	const std::string &to,
+	const neighbour_index &index,
+	search_state &state
+) -> ladder_stream {
+	no_stats stats;
+	return stream_ladders(from, to, index, state, stats);
+}
+
+auto word_ladder::generate(
+	const std::string &from,
+	const std::string &to,
+	const neighbour_index &index,
+	search_state &state
+) -> std::vector<std::vector<std::string>> {
+	std::vector<std::vector<std::string>> ret;
+	for (const auto &ladder : stream_ladders(from, to, index, state)) {
+		ret.push_back(ladder);
+	}
+	return ret;
+}
+
+word_ladder::solver::solver(const std::unordered_set<std::string> &lexicon, dictionary_backend backend)
+: solver(build_neighbour_indices(lexicon), backend) {}
+
+word_ladder::solver::solver(std::vector<neighbour_index> indices, dictionary_backend backend)
+: _indices(std::move(indices))
+, _backend(backend) {
+	if (_backend == dictionary_backend::hash_set) {
+		_hash_sets.resize(_indices.size());
+		for (std::size_t length = 0; length < _indices.size(); ++length) {
+			_hash_sets[length].reserve(_indices[length].size());
+			for (word_id id = 0; id < _indices[length].size(); ++id) {
+				_hash_sets[length].emplace(_indices[length].word(id), id);
+			}
+		}
+	}
+	_alphabets.reserve(_indices.size());
+	for (const auto &index : _indices) {
+		_alphabets.push_back(position_alphabets(index));
+	}
+}
+
+auto word_ladder::solver::backend() const noexcept -> dictionary_backend {
+	return _backend;
+}
+
+auto word_ladder::solver::find(std::string_view word) const -> std::optional<word_id> {
+	switch (_backend) {
+	case dictionary_backend::hash_set: {
+		auto const length = code_points(word);
+		if (length >= _hash_sets.size()) return std::nullopt;
+		auto it = _hash_sets[length].find(word);
+		if (it == _hash_sets[length].end()) return std::nullopt;
+		return it->second;
+	}
+	case dictionary_backend::sorted_array:
+		return index(code_points(word)).find_sorted(word);
+	case dictionary_backend::perfect_hash:
+		break;
+	}
+	return index(code_points(word)).find(word);
+}
+
+void word_ladder::solver::set_direction_policy(direction_policy policy) noexcept {
+	_policy = policy;
+}
+
+auto word_ladder::solver::last_search() const noexcept -> const search_state& {
+	static const search_state none;
+	return _last_state != nullptr ? *_last_state : none;
+}
+
+void word_ladder::solver::set_expansion_mode(expansion_mode mode) noexcept {
+	_expansion = mode;
+}
+
+void word_ladder::solver::set_expand_threads(std::size_t threads) noexcept {
+	_expand_threads = std::max<std::size_t>(1, threads);
+}
+
+auto word_ladder::solver::state_for(std::size_t length) -> search_state& {
+	auto const slot = std::min(length, _indices.size());
+	if (_states.size() <= slot) {
+		_states.resize(slot + 1);
+	}
+	auto &state = _states[slot];
+	if (!state) {
+		state = std::make_unique<search_state>();
+	}
+	state->policy = _policy;
+	state->expansion = _expansion;
+	state->expand_threads = _expand_threads;
+	if (!state->workers) {
+		state->workers = _workers;
+	}
+	return *state;
+}
+
+auto word_ladder::solver::index(std::size_t length) const noexcept -> const neighbour_index& {
+	return length < _indices.size() ? _indices[length] : _empty;
+}
+
+auto word_ladder::solver::search(
+    const std::string &from,
+    const std::string &to,
+    search_state &state,
+    ladder_dag &dag
+) const -> bool {
+	auto const length = code_points(from);
+	if (length != code_points(to)) return false;
+	const auto &idx = index(length);
+	auto from_id = find(from);
+	auto to_id = find(to);
+	// Same as stream_ladders: a word is no ladder to itself.
+	if (!from_id || !to_id || *from_id == *to_id || !idx.connected(*from_id, *to_id)) return false;
+
+	start_search(idx, state, *from_id, *to_id);
+	two_end_bfs(idx, state);
+	if (state.meetings.empty()) return false;
+	build_ladder_dag(state, dag);
+	return true;
+}
+
+auto word_ladder::solver::query_hash::operator()(const query &q) const noexcept -> std::size_t {
+	auto const h = std::hash<std::string>{};
+	return h(q.first) ^ (h(q.second) * 0x9e3779b97f4a7c15ULL);
+}
+
+void word_ladder::solver::set_cache_capacity(std::size_t capacity) {
+	_cache_capacity = capacity;
+	while (_cache.size() > _cache_capacity) {
+		_cache_slots.erase(_cache.back().first);
+		_cache.pop_back();
+	}
+}
+
+auto word_ladder::solver::cache_hits() const noexcept -> std::size_t {
+	return _cache_hits;
+}
+
+auto word_ladder::solver::cache_misses() const noexcept -> std::size_t {
+	return _cache_misses;
+}
+
+auto word_ladder::solver::cached(const std::string &from, const std::string &to)
+    -> const std::vector<std::vector<std::string>>* {
+	auto slot = _cache_slots.find(query(from, to));
+	if (slot == _cache_slots.end()) return nullptr;
+	_cache.splice(_cache.begin(), _cache, slot->second);
+	return &slot->second->second;
+}
+
+auto word_ladder::solver::generate(const std::string &from, const std::string &to)
+    -> std::vector<std::vector<std::string>> {
+	std::vector<std::vector<std::string>> ret;
+	if (_cache_capacity > 0) {
+		if (auto hit = cached(from, to)) {
+			++_cache_hits;
+			return *hit;
+		}
+		if (auto hit = cached(to, from)) {
+			++_cache_hits;
+			ret = *hit;
+			for (auto &ladder : ret) {
+				std::reverse(ladder.begin(), ladder.end());
+			}
+			std::sort(ret.begin(), ret.end(), less_comparator);
+			return ret;
+		}
+		++_cache_misses;
+	}
+
+	auto ladders = stream(from, to);
+	for (const auto &ladder : ladders) {
+		ret.push_back(ladder);
+	}
+
+	if (_cache_capacity > 0) {
+		if (_cache.size() == _cache_capacity) {
+			_cache_slots.erase(_cache.back().first);
+			_cache.pop_back();
+		}
+		_cache.emplace_front(query(from, to), ret);
+		_cache_slots.emplace(_cache.front().first, _cache.begin());
+	}
+	return ret;
+}
+
+auto word_ladder::solver::bounded_distance(const std::string &from, const std::string &to, std::size_t limit)
+    -> std::optional<std::size_t> {
+	auto const length = code_points(from);
+	if (length != code_points(to)) return std::nullopt;
+	auto from_id = find(from);
+	auto to_id = find(to);
+	if (!from_id || !to_id) return std::nullopt;
+
+	const auto &idx = index(length);
+	if (_landmarks.size() <= length) {
+		_landmarks.resize(length + 1);
+	}
+	auto &landmarks = _landmarks[length];
+	if (landmarks.words != idx.size()) {
+		landmarks = build_landmark_index(idx);
+	}
+	return landmark_distance(idx, landmarks, state_for(length), *from_id, *to_id, limit);
+}
+
+auto word_ladder::solver::best_ladder(
+	const std::string &from,
+	const std::string &to,
+	const substitution_costs &costs
+) const -> weighted_ladder {
+	auto const length = code_points(from);
+	if (length != code_points(to)) return {};
+	if (length >= _alphabets.size()) return {};
+	return word_ladder::best_ladder(from, to, index(length), costs, _alphabets[length]);
+}
+
+auto word_ladder::solver::distance(const std::string &from, const std::string &to)
+    -> std::optional<std::size_t> {
+	return bounded_distance(from, to, SIZE_MAX);
+}
+
+auto word_ladder::solver::reachable_within(const std::string &from, const std::string &to, std::size_t steps)
+    -> bool {
+	return bounded_distance(from, to, steps).has_value();
+}
+
+auto word_ladder::solver::stream(const std::string &from, const std::string &to) -> ladder_stream {
+	auto &state = state_for(code_points(from));
+	_last_state = &state;
+	auto const found = search(from, to, state, _dag);
+	_workers = state.workers;
+	if (!found) return {};
+	return ladder_stream(index(code_points(from)), _dag);
+}
+
+auto word_ladder::solver::length_order(std::span<const std::pair<std::string, std::string>> queries)
+    -> std::vector<std::size_t> {
+	std::vector<std::size_t> order(queries.size());
+	for (std::size_t i = 0; i < order.size(); ++i) {
+		order[i] = i;
+	}
+	std::stable_sort(order.begin(), order.end(), [&](std::size_t a, std::size_t b) {
+		return code_points(queries[a].first) < code_points(queries[b].first);
+	});
+	return order;
+}
+
+auto word_ladder::solver::solve_batch(std::span<const std::pair<std::string, std::string>> queries)
+    -> std::vector<std::vector<std::vector<std::string>>> {
+	std::vector<std::vector<std::vector<std::string>>> ret(queries.size());
+	// Streams rather than generate, so a batch neither reads nor fills the cache.
+	for (auto i : length_order(queries)) {
+		for (const auto &ladder : stream(queries[i].first, queries[i].second)) {
+			ret[i].push_back(ladder);
+		}
+	}
+	return ret;
+}
+
+auto word_ladder::solver::solve_batch_parallel(
+    std::span<const std::pair<std::string, std::string>> queries,
+    std::size_t threads
+) const -> std::vector<std::vector<std::vector<std::string>>> {
+	if (threads == 0) {
+		threads = std::max<std::size_t>(1, std::thread::hardware_concurrency());
+	}
+	threads = std::max<std::size_t>(1, std::min(threads, queries.size()));
+
+	// Every query is known up front, so a worker only ever takes work out of the queues:
+	// its own from the front, other workers' from the back. Once every queue is empty
+	// the batch is done.
+	struct work_queue {
+		std::mutex mutex;
+		std::deque<std::size_t> queries;
+	};
+	std::vector<work_queue> queues(threads);
+	auto const order = length_order(queries);
+	for (std::size_t i = 0; i < order.size(); ++i) {
+		queues[i * threads / order.size()].queries.push_back(order[i]);
+	}
+
+	auto take = [&](std::size_t self) -> std::optional<std::size_t> {
+		{
+			std::lock_guard lock(queues[self].mutex);
+			if (!queues[self].queries.empty()) {
+				auto query = queues[self].queries.front();
+				queues[self].queries.pop_front();
+				return query;
+			}
+		}
+		while (true) {
+			std::size_t victim = self;
+			std::size_t most = 0;
+			for (std::size_t i = 0; i < threads; ++i) {
+				std::lock_guard lock(queues[i].mutex);
+				if (queues[i].queries.size() > most) {
+					most = queues[i].queries.size();
+					victim = i;
+				}
+			}
+			if (victim == self) return std::nullopt;
+			// Another thief may have emptied the victim since it was picked: look again.
+			std::lock_guard lock(queues[victim].mutex);
+			if (!queues[victim].queries.empty()) {
+				auto query = queues[victim].queries.back();
+				queues[victim].queries.pop_back();
+				return query;
+			}
+		}
+	};
+
+	std::vector<std::vector<std::vector<std::string>>> ret(queries.size());
+	auto work = [&](std::size_t self) {
+		search_state state;
+		ladder_dag dag;
+		while (auto query = take(self)) {
+			const auto &[from, to] = queries[*query];
+			if (!search(from, to, state, dag)) continue;
+			ladder_stream ladders(index(code_points(from)), dag);
+			for (const auto &ladder : ladders) {
+				ret[*query].push_back(ladder);
+			}
+		}
+	};
+	{
+		std::vector<std::jthread> workers;
+		for (std::size_t i = 1; i < threads; ++i) {
+			workers.emplace_back(work, i);
+		}
+		work(0);
+	}
+	return ret;
+}
@@ -11,6 +11,18 @@
 #include <algorithm>
 #include <set>
 #include <climits>
+#include <iterator>
+#include <memory>
+#include <stdexcept>
+#include <optional>
+#include <cstdint>
+#include <span>
+#include <bit>
+#include <list>
+#include <chrono>
+#include <memory_resource>
+#include <functional>
+#include <map>
 
 /*
     Why I choose Two-End-BFS to solve this assignment:
@@ -31,7 +43,7 @@ auto read_lexicon(const std::string& path) -> std::unordered_set<std::string>;
 // start word to the destination, where each word in an individual path is a valid word per the
 // provided lexicon.
 // Preconditions:
-// - from.size() == to.size()
+// - from and to have the same number of code points (see code_points)
 // - lexicon.contains(from)
 // - lexicon.contains(to)
 auto generate(
@@ -39,15 +51,313 @@ auto generate(
     const std::string& to,
     const std::unordered_set<std::string>& lexicon) -> std::vector<std::vector<std::string>>;
 
+// Number of code points of a UTF-8 word, i.e. of its bytes that do not continue a multi-byte
+// sequence. Words are grouped and compared letter by letter in code points, so a plain ASCII
+// word has as many letters as bytes and "café" has four.
+auto code_points(std::string_view word) noexcept -> std::size_t;
+
+// Dense integer id of a word inside one neighbour index.
+// Ids follow the lexicographic order of the words, so comparing ids compares words.
+using word_id = std::uint32_t;
+
+// Wildcard-bucket adjacency index for every word of one length.
+// Each word of the lexicon is filed under its length wildcard patterns, e.g. "cat" is filed
+// under "*at", "c*t" and "ca*". A wildcard replaces a whole code point, never part of one.
+// Two words are one letter apart exactly when they share a bucket, so neighbours are found by
+// walking length buckets instead of probing 25 * length strings.
+// Words are interned into dense ids and buckets are stored as flat id arrays, so the search
+// never touches a string until the final ladders are returned.
+// All arrays are read-only views into storage, which is either owned by the index or a
+// compiled lexicon file mapped into memory, so copying an index is cheap and shares them.
+struct neighbour_index {
+	// Code points in every word.
+	std::size_t length = 0;
+	// The words back to back in id order, each length chars long unless word_offsets is set.
+	std::span<const char> text;
+	// Where each word starts in text, plus the end of text. Only set when some word has
+	// multi-byte code points; all-ASCII indices keep fixed-width words instead.
+	std::span<const std::uint32_t> word_offsets;
+	// Bucket b holds bucket_words[bucket_offsets[b]] up to bucket_words[bucket_offsets[b + 1]].
+	std::span<const std::uint32_t> bucket_offsets;
+	std::span<const word_id> bucket_words;
+	// word_buckets[id * length + pos] is the bucket of the words that differ from id only at
+	// code point pos.
+	std::span<const std::uint32_t> word_buckets;
+	// Minimal perfect hash of the words: the hash of a word picks a displacement, which
+	// picks the slot holding its id. See find.
+	std::span<const std::uint32_t> hash_displacements;
+	std::span<const word_id> hash_slots;
+	// packed[id] is the pack_word code of word id. Empty unless every word packs.
+	std::span<const std::uint64_t> packed;
+	// components[id] labels the connected component of word id: two words have a ladder
+	// between them exactly when their labels are equal. Labels are numbered from 0.
+	std::span<const std::uint32_t> components;
+	// Keeps whatever the views point into alive.
+	std::shared_ptr<const void> storage;
+
+	// Number of words in the index.
+	auto size() const noexcept -> std::size_t;
+	// The word with the given id.
+	auto word(word_id id) const noexcept -> std::string_view;
+	// The id of word, if it is in the index, looked up through the perfect hash if it has one.
+	auto find(std::string_view word) const noexcept -> std::optional<word_id>;
+	// The id of word, if it is in the index, by binary search over the sorted text.
+	auto find_sorted(std::string_view word) const noexcept -> std::optional<word_id>;
+	// Returns the ids of the words that match word id everywhere but pos, including id itself.
+	auto bucket(word_id id, std::size_t pos) const -> std::span<const word_id>;
+	// Number of words one letter away from word id.
+	auto degree(word_id id) const -> std::size_t;
+	// Whether some ladder joins from and to. Always true if the index has no components.
+	auto connected(word_id from, word_id to) const noexcept -> bool;
+};
+
+// Longest word pack_word can encode.
+constexpr std::size_t max_packed_length = 12;
+
+// Pack a word of lowercase letters into 5 bits per letter, first letter lowest.
+// Two packed words of the same length are one letter apart exactly when their xor has
+// exactly one non-zero 5-bit lane. Empty for longer words or any other character.
+auto pack_word(std::string_view word) noexcept -> std::optional<std::uint64_t>;
+
+// How much of a neighbour index build_neighbour_index builds.
+enum class index_parts {
+	// Everything: buckets, perfect hash, packed codes and components.
+	all,
+	// Only the words and their buckets, for an index that serves a single query. find then
+	// falls back to find_sorted, searches walk buckets, and every pair counts as connected.
+	buckets,
+};
+
+// Build the neighbour index of all words in lexicon with length code points.
+// Build it once per word length and reuse it across generate calls on the same lexicon.
+auto build_neighbour_index(
+    std::size_t length,
+    const std::unordered_set<std::string> &lexicon,
+    index_parts parts = index_parts::all
+) -> neighbour_index;
+
+// Build the neighbour index of words, which must all have the given length.
+// The index copies the words, so they need not outlive it.
+auto build_neighbour_index(
+    std::size_t length,
+    std::vector<std::string_view> words,
+    index_parts parts = index_parts::all
+) -> neighbour_index;
+
+// Build the neighbour index of every word length in lexicon; the result is indexed by length.
+auto build_neighbour_indices(const std::unordered_set<std::string> &lexicon) -> std::vector<neighbour_index>;
+
+// Write indices, indexed by word length, to path as a compiled lexicon.
+// A compiled lexicon holds every array of every index, 8-byte aligned, behind a small table
+// of contents, so map_lexicon can use it in place without parsing or copying anything.
+// Throws std::runtime_error if an index was built with index_parts::buckets, or if the file
+// cannot be written.
+void save_lexicon(const std::string& path, std::span<const neighbour_index> indices);
+
+// Map a compiled lexicon written by save_lexicon into memory and return its indices,
+// indexed by word length. The indices view the mapping directly and keep it alive.
+// Every offset, id and bucket number in the file is checked once, in a single pass, so no
+// lookup can read outside the mapping; the words themselves are trusted to be sorted.
+// Throws std::runtime_error if the file cannot be mapped, is not a compiled lexicon, or
+// fails those checks.
+auto map_lexicon(const std::string& path) -> std::vector<neighbour_index>;
+
+// Same as generate above, but walks a prebuilt neighbour index instead of building one.
+// Every call sizes a new search_state to the index; to answer many queries, pass one
+// search_state to the overload below, or use a solver.
+// Preconditions:
+// - index.length == code_points(from)
+auto generate(
+    const std::string& from,
+    const std::string& to,
+    const neighbour_index& index) -> std::vector<std::vector<std::string>>;
+
+// How a search finds the neighbours of a word.
+enum class expansion_mode {
+	// Walk the wildcard buckets of the word, one per letter position.
+	buckets,
+	// Compare the packed code of the word against the packed codes of the whole index with
+	// branch-free xor and lane tests that the compiler vectorises. The scan costs the size
+	// of the index per word whatever its degree, so it only competes with buckets on very
+	// small indices. Indices that do not pack fall back to buckets.
+	packed_scan,
+};
+
+// How a two end search decides which end to expand next.
+enum class direction_policy {
+	// Expand the end with fewer frontier words.
+	frontier_size,
+	// Expand the end whose frontier has the smaller sum of word degrees, i.e. the end that
+	// will scan fewer neighbours, so a small frontier of hub words is not picked over a
+	// larger frontier of nearly isolated ones.
+	expansion_cost,
+};
+
+// One decision of the direction scheduler: both frontiers as they were, and which was expanded.
+struct expansion_step {
+	bool expanded_from_side = false;
+	std::size_t from_size = 0;
+	std::size_t to_size = 0;
+	std::size_t from_cost = 0;
+	std::size_t to_cost = 0;
+};
+
+// A set of the word ids of one index, one bit per word.
+// Marking and membership are single word operations, and iteration scans set bits.
+class word_bitset {
+ public:
+	// Size the set for words ids and empty it.
+	void reset(std::size_t words);
+	// Empty the set, keeping its size.
+	void clear() noexcept;
+	auto size() const noexcept -> std::size_t;
+	auto test(word_id id) const noexcept -> bool {
+		return (_bits[id / 64] >> (id % 64)) & 1U;
+	}
+	void set(word_id id) noexcept {
+		_bits[id / 64] |= std::uint64_t {1} << (id % 64);
+	}
+	// Number of 64 bit blocks; block b holds ids b * 64 up to b * 64 + 63.
+	auto blocks() const noexcept -> std::size_t;
+	// Call visit(id) for every id in the set that lies in blocks first up to last, ascending.
+	template <typename Visit>
+	void for_each(Visit visit, std::size_t first, std::size_t last) const {
+		for (auto b = first; b < last; ++b) {
+			for (auto bits = _bits[b]; bits != 0; bits &= bits - 1) {
+				visit(static_cast<word_id>(b * 64 + static_cast<std::size_t>(std::countr_zero(bits))));
+			}
+		}
+	}
+	template <typename Visit>
+	void for_each(Visit visit) const {
+		for_each(visit, 0, _bits.size());
+	}
+	friend void swap(word_bitset& a, word_bitset& b) noexcept {
+		std::swap(a._bits, b._bits);
+		std::swap(a._size, b._size);
+	}
+
+ private:
+	std::vector<std::uint64_t> _bits;
+	std::size_t _size = 0;
+};
+
+// Scratch memory for one query at a time. Allocations bump through a buffer that is kept
+// between queries, and reset drops all of them at once. A query that outgrows the buffer
+// spills to the heap, and the next reset grows the buffer by what was spilled, so a steady
+// run of similar queries makes no heap allocations at all.
+class scratch_arena : public std::pmr::memory_resource {
+ public:
+	explicit scratch_arena(std::size_t capacity = 64 * 1024);
+	// Invalidates everything allocated from the arena since the last reset.
+	void reset();
+	// Bytes of the buffer, and bytes spilled to the heap since the last reset.
+	auto capacity() const noexcept -> std::size_t;
+	auto spilled() const noexcept -> std::size_t;
+
+ private:
+	// The heap behind the buffer, counting what it hands out.
+	class spill_resource : public std::pmr::memory_resource {
+	 public:
+		std::size_t bytes = 0;
+
+	 private:
+		auto do_allocate(std::size_t bytes, std::size_t alignment) -> void* override;
+		void do_deallocate(void* p, std::size_t bytes, std::size_t alignment) override;
+		auto do_is_equal(const std::pmr::memory_resource& other) const noexcept -> bool override;
+	};
+
+	auto do_allocate(std::size_t bytes, std::size_t alignment) -> void* override;
+	void do_deallocate(void* p, std::size_t bytes, std::size_t alignment) override;
+	auto do_is_equal(const std::pmr::memory_resource& other) const noexcept -> bool override;
+
+	spill_resource _spill;
+	std::vector<std::byte> _buffer;
+	std::optional<std::pmr::monotonic_buffer_resource> _arena;
+};
+
+// Threads that expand the slices of parallel levels, defined in word_ladder.cpp.
+class expand_pool;
+
+// Flat state of a two end search over the word ids of one neighbour index.
+// Bitsets and arrays indexed by word id are sized to the index once, so one state can be
+// reused as scratch space across many queries with no allocation per level.
+struct search_state {
+	// Frontier of the side expanded next, frontier of the other side, and the level being
+	// built, with the number of words in each.
+	word_bitset begin_set;
+	word_bitset end_set;
+	word_bitset next_level;
+	std::size_t begin_size = 0;
+	std::size_t end_size = 0;
+	std::size_t next_size = 0;
+	// Sum of the degrees of the words in begin_set and in end_set.
+	std::size_t begin_cost = 0;
+	std::size_t end_cost = 0;
+	direction_policy policy = direction_policy::expansion_cost;
+	// Every scheduler decision of the last search, in order. The neighbours it scanned are
+	// the sum of the cost of the expanded end over all steps.
+	std::vector<expansion_step> steps;
+	// Words reached from the from end and from the to end.
+	word_bitset from_reached;
+	word_bitset to_reached;
+	// Memory of the per-query parts below, reset by start_search. Held by pointer so the
+	// parent lists can keep pointing at it when the state moves.
+	std::unique_ptr<scratch_arena> arena = std::make_unique<scratch_arena>();
+	// Predecessors of a word on its shortest paths back to the end that reached it.
+	// Ladders are only enumerated from these links once the search is over, so memory grows
+	// with the words visited rather than with the number of partial paths.
+	// Every list allocates from arena.
+	std::vector<std::pmr::vector<word_id>> parents;
+	// Edges where the two ends met, as (word on the from side, word on the to side).
+	std::vector<std::pair<word_id, word_id>> meetings;
+	// Every word either end reached, so the next query only resets those.
+	std::vector<word_id> visited;
+	// Scratch numbering of the words on a shortest ladder, used by build_ladder_dag.
+	std::vector<std::uint32_t> local;
+	// True when begin_set is the to side of the search.
+	bool reversed = false;
+	bool found = false;
+	expansion_mode expansion = expansion_mode::buckets;
+	// Opt-in parallel expansion: levels of at least parallel_min_frontier words are split
+	// across expand_threads threads. Results are identical to a serial search.
+	std::size_t expand_threads = 1;
+	std::size_t parallel_min_frontier = 1024;
+	// Per-thread buffers of a parallel level: (word, neighbour) edges into unreached words
+	// and meeting edges, in the order a serial expansion would have found them.
+	// Threads split the frontier bitset by 64 bit blocks.
+	std::vector<std::vector<std::pair<word_id, word_id>>> thread_edges;
+	std::vector<std::vector<std::pair<word_id, word_id>>> thread_meetings;
+	// expand_threads - 1 workers, started by the first parallel level and kept for the
+	// levels and queries after it. A shared_ptr, so the pool's type stays out of this header.
+	std::shared_ptr<expand_pool> workers;
+};
+
+// Forward links between the words on the shortest ladders of one query.
+// Words are numbered locally so the DAG only takes space for the words on some ladder.
+struct ladder_dag {
+	// words[n] is the word id of local word n.
+	std::vector<word_id> words;
+	// Local word n is followed by children[offsets[n]] up to children[offsets[n + 1]],
+	// in ascending word id order.
+	std::vector<std::uint32_t> offsets;
+	std::vector<std::uint32_t> children;
+	// Local numbers of `from` and `to`.
+	std::uint32_t from = 0;
+	std::uint32_t to = 0;
+};
+
 // Compare two vectors with ascending order.
+// generate no longer sorts with it, since ladders are emitted in this order already.
 // Preconditions:
 // - v1 and v2 are not empty.
 auto less_comparator(
-    const std::vector<std::string> v1, 
-    const std::vector<std::string> v2) -> bool;
+    const std::vector<std::string>& v1,
+    const std::vector<std::string>& v2) -> bool;
 
 // Filter lexicon with length.
-// Find the same length word in lexicon and add to a new dictionary with type of string_view.
+// Find the words of length code points in lexicon and add to a new dictionary with type of
+// string_view.
 // Preconditions:
 // length >= 0.
 // length <= INT_MAX.
@@ -56,86 +366,524 @@ auto filtered_dict(
     const std::unordered_set<std::string> &lexicon
 ) -> std::unordered_set<std::string_view>;
 
-// Swap Set1 and Set2 when length of Set1 is larger than Set2, also swap Map1 and Map2.
-// Use reversed as control flag that distinguish with Setss original status.
-// Preconditions:
-// begin_set, end_set are exist.
-// begin_map, end_map are exist.
-void swap_set_with_smaller_len(
-    std::unordered_set<std::string> &begin_set, 
-    std::unordered_set<std::string> &end_set, 
-    bool &reversed, 
-    std::unordered_map<std::string, std::vector<std::vector<std::string>>> &begin_map,
-    std::unordered_map<std::string, std::vector<std::vector<std::string>>> &end_map
-);
+// Swap begin_set and end_set when begin_set is the more expensive one to expand under
+// state.policy, so the cheaper frontier is expanded, and record the decision in steps.
+// Use reversed as control flag that distinguish with Sets original status.
+void swap_set_with_smaller_len(search_state &state);
 
-// Erase dict's word that is also in begin_set
-void erase_word(
-    std::unordered_set<std::string_view> &dict, 
-    const std::unordered_set<std::string> &begin_set
-);
+// A neighbour of word that no end has reached yet, or that is already in the level being built.
+// We need to add cur_word to the next level and record word as one of its parents.
+void not_find_end_word(search_state &state, word_id cur_word, word_id word);
 
-// In a-z word sub loop, find a word that is in dict but is not the end word.
-// We need to add current word to the loop level that represent increasing the loop level.
-// And then and the current word to the map .
-void not_find_end_word(
-    std::unordered_set<std::string> &next_level, 
-    std::unordered_map<std::string, std::vector<std::vector<std::string>>> &begin_map, 
-    const std::string &cur_word,
-    const std::string &word
-);
+// A neighbour of word that is in end_set, so the two ends of the search meet.
+// Use reversed flag to record the edge in from side -> to side order.
+void found_end_word(search_state &state, word_id cur_word, word_id word);
 
-// In a-z word sub loop, find a word that is end word.
-// We need to extract word from begin_map and end_map by using cur_word and word
-// To find its effecienct position.
-// And then use reversed flag to combine 
-// its order with { words in begin_map + the words in end_map };
-// Push it to ret as one result and establish a loop to extract all results.
-void found_end_word(
-    std::unordered_map<std::string, std::vector<std::vector<std::string>>> &begin_map,
-    std::unordered_map<std::string, std::vector<std::vector<std::string>>> &end_map,
-    const bool &reversed,
-    const std::string &cur_word,
-    const std::string &word,
-    std::vector<std::vector<std::string>> &ret
+// Walk the bucket of the words that differ from word only at pos.
+// If a word is in end_set the ends meet, otherwise if no end has reached it
+// We can add the new word to the next_level.
+void walk_neighbour_bucket(
+    const neighbour_index &index,
+    search_state &state,
+    word_id word,
+    std::size_t pos
 );
 
-// Sub word with the pos by using loop of a-z to get a new word.
-// Use the word compared to the word in end_set.
-// If it's not in end_set but it occurs in dict
-// We can add the new word to the next_level and begin_map
-// If it's in end_set, we can find the shortest path by extracting
-// the words from begin_set and end_set. 
-void sub_a_z_letter(
-    std::unordered_set<std::string> &end_set,
-    std::unordered_map<std::string, std::vector<std::vector<std::string>>> &begin_map,
-    std::unordered_map<std::string, std::vector<std::vector<std::string>>> &end_map,
-    bool reversed,
-    bool &found,
-    std::vector<std::vector<std::string>> &ret,
-    std::string &cur_word,
-    std::string word,
-    std::size_t &i,
-    std::unordered_set<std::string> &next_level,
-    std::unordered_set<std::string_view> &dict
+// Scan the packed codes of index for the neighbours of word, in id order, and handle each
+// of them the way walk_neighbour_bucket does.
+// Preconditions:
+// - index.packed is not empty
+void walk_packed_neighbours(
+    const neighbour_index &index,
+    search_state &state,
+    word_id word
 );
 
+// Expand the whole of begin_set by one level across state.expand_threads threads: the
+// caller and the workers of state, which are started on first use.
+// Each thread scans a contiguous slice of the frontier against the reached words of the
+// previous levels only, collecting its edges in its own buffers. The buffers are then
+// merged in slice order, so next_level, parents and meetings come out exactly as the
+// serial expansion would have left them.
+void parallel_expand_level(const neighbour_index &index, search_state &state);
+
+// Prepare state for a search from -> to over index. Its buffers are reused as they are
+// when they already have the size of index, resetting only what the last query touched.
+void start_search(const neighbour_index &index, search_state &state, word_id from, word_id to);
+
 // Use Two-End-BFS to improve the original BFS algorithm.
-// Define two sets -- begin_set with from and end_set with to.
-// Use begin_set and end_set to instead of one queue in loop.
-// begin_map and end_map to record all possible words.
-// Use begin_set as main queue to go loop when begin_set is lager than
-// end_set.
-void two_end_bfs(
-    std::unordered_set<std::string> &begin_set,
-    std::unordered_set<std::string> &end_set,
-    std::unordered_map<std::string, std::vector<std::vector<std::string>>> &begin_map,
-    std::unordered_map<std::string, std::vector<std::vector<std::string>>> &end_map,
-    bool reversed,
-    std::vector<std::vector<std::string>> &ret,
-    std::unordered_set<std::string_view> dict,
-    std::size_t length,
-    bool found
-);
+// Start with begin_set holding from and end_set holding to.
+// Always expand the smaller frontier by one whole level,
+// and stop at the first level where the two ends meet.
+void two_end_bfs(const neighbour_index &index, search_state &state);
+
+// Turn the parent links of a search that found `to` into the forward ladder DAG.
+// Only the words on some shortest ladder end up in dag.
+void build_ladder_dag(search_state &state, ladder_dag &dag);
+
+// Lazily enumerates the shortest ladders of one query in lexicographic order.
+// The search itself runs when the stream is created, but ladders are only walked out of
+// the ladder DAG one at a time as the stream is iterated, so taking the first few ladders
+// never pays for the rest. Single pass: iterate it once, and do not move it while iterating.
+class ladder_stream {
+ public:
+	class iterator {
+	 public:
+		using iterator_category = std::input_iterator_tag;
+		using value_type = std::vector<std::string>;
+		using difference_type = std::ptrdiff_t;
+		using pointer = const value_type*;
+		using reference = const value_type&;
+		iterator() noexcept = default;
+		explicit iterator(ladder_stream* stream) noexcept;
+		auto operator*() const noexcept -> const std::vector<std::string>&;
+		auto operator->() const noexcept -> const std::vector<std::string>*;
+		auto operator++() -> iterator&;
+		auto operator++(int) -> void;
+		friend auto operator==(const iterator& it, std::default_sentinel_t) noexcept -> bool {
+			return it.at_end();
+		}
+
+	 private:
+		auto at_end() const noexcept -> bool;
+
+		ladder_stream* _stream = nullptr;
+	};
+
+	ladder_stream() noexcept = default;
+	ladder_stream(const neighbour_index& index, ladder_dag dag);
+	// Stream the ladders of dag, whose word ids word turns back into words.
+	ladder_stream(std::function<std::string_view(word_id)> word, ladder_dag dag);
+	auto begin() -> iterator;
+	auto end() const noexcept -> std::default_sentinel_t;
+	// The ids of the current ladder, for callers that want to stay in id space.
+	auto ids() const noexcept -> const std::vector<word_id>&;
+
+ private:
+	// Advance the DFS to the next complete ladder; false once every ladder has been produced.
+	auto advance() -> bool;
+
+	std::function<std::string_view(word_id)> _word;
+	ladder_dag _dag;
+	// DFS stack: the ladder so far as local words, and for each of them the next child to try.
+	std::vector<std::uint32_t> _path;
+	std::vector<std::uint32_t> _child;
+	std::vector<word_id> _ids;
+	std::vector<std::string> _current;
+	bool _started = false;
+	bool _done = true;
+};
+
+// Run the search for from -> to and return a stream over its shortest ladders.
+// An unknown word or an unreachable pair gives an empty stream.
+// Every call sizes a new search_state to the index, as generate does.
+// Preconditions:
+// - index.length == code_points(from)
+auto stream_ladders(
+    const std::string& from,
+    const std::string& to,
+    const neighbour_index& index) -> ladder_stream;
+
+// Same as the two above, searching with state. A state kept by the caller across queries on
+// one index only resets the words the last query touched, like the state of a solver.
+auto stream_ladders(
+    const std::string& from,
+    const std::string& to,
+    const neighbour_index& index,
+    search_state& state) -> ladder_stream;
+auto generate(
+    const std::string& from,
+    const std::string& to,
+    const neighbour_index& index,
+    search_state& state) -> std::vector<std::vector<std::string>>;
+
+// Neighbour index of a whole lexicon for ladders whose steps may also insert or delete
+// one letter, so consecutive words may differ in length by one.
+// Ids follow the lexicographic order of all words, so comparing ids compares words and a
+// word is found by binary search, and the neighbours of every word are stored outright,
+// sorted by id.
+struct edit_index {
+	std::vector<std::string> words;
+	// The neighbours of word id are neighbours[offsets[id]] up to neighbours[offsets[id + 1]].
+	std::vector<std::uint32_t> offsets;
+	std::vector<word_id> neighbours;
+	// components[id] labels the connected component of word id, as in neighbour_index.
+	std::vector<std::uint32_t> components;
+
+	auto size() const noexcept -> std::size_t;
+	auto word(word_id id) const noexcept -> std::string_view;
+	auto find(std::string_view word) const -> std::optional<word_id>;
+	// Words one substitution, insertion or deletion away from word id.
+	auto neighbours_of(word_id id) const noexcept -> std::span<const word_id>;
+	auto degree(word_id id) const noexcept -> std::size_t;
+};
+
+// Build the edit index of lexicon by deletion neighbourhood hashing: every word is filed
+// under each string it gives when one letter is deleted, together with that letter's
+// position. Words filed under the same string at the same position are one substitution
+// apart, and a word filed under another word is that word plus one letter. Only words
+// that share a key are ever compared, however large the lexicon.
+auto build_edit_index(const std::unordered_set<std::string>& lexicon) -> edit_index;
+
+// Prepare state for a search of index from word from to word to.
+void start_search(const edit_index& index, search_state& state, word_id from, word_id to);
+// Same as the two_end_bfs above, over the substitution, insertion and deletion steps of index.
+void two_end_bfs(const edit_index& index, search_state& state);
+
+// All shortest ladders from -> to where each step substitutes, inserts or deletes one
+// letter, in lexicographic order. Unlike generate, from and to may differ in length.
+// An unknown word or an unreachable pair gives an empty stream.
+// The stream refers to index, so index must outlive it.
+auto stream_edit_ladders(
+    const std::string& from,
+    const std::string& to,
+    const edit_index& index) -> ladder_stream;
+auto generate_edit_ladders(
+    const std::string& from,
+    const std::string& to,
+    const edit_index& index) -> std::vector<std::vector<std::string>>;
+// Same as above, building the edit index of lexicon first.
+auto generate_edit_ladders(
+    const std::string& from,
+    const std::string& to,
+    const std::unordered_set<std::string>& lexicon) -> std::vector<std::vector<std::string>>;
+
+// Instrumentation policy of generate and stream_ladders that records nothing. Every hook is
+// behind if constexpr (Stats::enabled), so with this policy they compile away entirely.
+struct no_stats {
+	static constexpr bool enabled = false;
+};
+
+// Instrumentation policy that records where a query spent its effort. Counters add up over
+// every call the same stats object is passed to.
+struct search_stats {
+	static constexpr bool enabled = true;
+	// Building the neighbour index of the query's length out of the lexicon.
+	std::chrono::nanoseconds filter_time {};
+	// The two end BFS, from the first word lookup to the meeting level.
+	std::chrono::nanoseconds search_time {};
+	// Walking the ladders out of the ladder DAG. They come out already in order, so this
+	// is all the ordering work there is.
+	std::chrono::nanoseconds emit_time {};
+	// Size of the from and the to frontier each time that end was expanded, in order.
+	std::vector<std::size_t> from_levels;
+	std::vector<std::size_t> to_levels;
+	// Neighbours scanned while expanding, each checked against the reached words of both ends.
+	// Past the two lookups of the query's words the search works on ids, so these checks are
+	// all the lookups it does.
+	std::size_t neighbours_scanned = 0;
+	std::size_t paths = 0;
+};
+
+// Same as stream_ladders above, searching with state and recording the search into stats.
+template <typename Stats>
+auto stream_ladders(
+    const std::string& from,
+    const std::string& to,
+    const neighbour_index& index,
+    search_state& state,
+    Stats& stats) -> ladder_stream {
+	[[maybe_unused]] auto const start = [] {
+		if constexpr (Stats::enabled) return std::chrono::steady_clock::now();
+		else return 0;
+	}();
+	auto from_id = index.find(from);
+	auto to_id = index.find(to);
+	// A word is no ladder to itself; searching would meet at the start and loop the ladder DAG.
+	if (!from_id || !to_id || *from_id == *to_id || !index.connected(*from_id, *to_id)) {
+		return {};
+	}
+
+	start_search(index, state, *from_id, *to_id);
+	two_end_bfs(index, state);
+	if constexpr (Stats::enabled) {
+		stats.search_time += std::chrono::steady_clock::now() - start;
+		for (const auto& step : state.steps) {
+			if (step.expanded_from_side) {
+				stats.from_levels.push_back(step.from_size);
+				stats.neighbours_scanned += step.from_cost;
+			} else {
+				stats.to_levels.push_back(step.to_size);
+				stats.neighbours_scanned += step.to_cost;
+			}
+		}
+	}
+	if (state.meetings.empty()) {
+		return {};
+	}
+
+	ladder_dag dag;
+	build_ladder_dag(state, dag);
+	return ladder_stream(index, std::move(dag));
+}
+
+// Same as stream_ladders above, recording the search into stats.
+template <typename Stats>
+auto stream_ladders(
+    const std::string& from,
+    const std::string& to,
+    const neighbour_index& index,
+    Stats& stats) -> ladder_stream {
+	search_state state;
+	return stream_ladders(from, to, index, state, stats);
+}
+
+// Same as generate above, recording the search into stats.
+template <typename Stats>
+auto generate(
+    const std::string& from,
+    const std::string& to,
+    const neighbour_index& index,
+    Stats& stats) -> std::vector<std::vector<std::string>> {
+	std::vector<std::vector<std::string>> ret;
+	auto stream = stream_ladders(from, to, index, stats);
+	[[maybe_unused]] auto const start = [] {
+		if constexpr (Stats::enabled) return std::chrono::steady_clock::now();
+		else return 0;
+	}();
+	for (const auto& ladder : stream) {
+		ret.push_back(ladder);
+	}
+	if constexpr (Stats::enabled) {
+		stats.emit_time += std::chrono::steady_clock::now() - start;
+		stats.paths += ret.size();
+	}
+	return ret;
+}
+
+// Same as generate above, recording the search into stats.
+template <typename Stats>
+auto generate(
+    const std::string& from,
+    const std::string& to,
+    const std::unordered_set<std::string>& lexicon,
+    Stats& stats) -> std::vector<std::vector<std::string>> {
+	[[maybe_unused]] auto const start = [] {
+		if constexpr (Stats::enabled) return std::chrono::steady_clock::now();
+		else return 0;
+	}();
+	// A one-off index is searched once, so it is not worth building more than its buckets.
+	auto const index = build_neighbour_index(code_points(from), lexicon, index_parts::buckets);
+	if constexpr (Stats::enabled) stats.filter_time += std::chrono::steady_clock::now() - start;
+	return generate(from, to, index, stats);
+}
+
+// Exact step counts from a few landmark words to every word of one index.
+// By the triangle inequality, |d(l, from) - d(l, to)| <= d(from, to) <= d(l, from) + d(l, to)
+// for every landmark l, so a query often gets its distance without searching at all.
+struct landmark_index {
+	static constexpr std::uint16_t unreachable = UINT16_MAX;
+	std::vector<word_id> landmarks;
+	// distances[l * words + id] is the number of steps from landmarks[l] to word id.
+	std::vector<std::uint16_t> distances;
+	std::size_t words = 0;
+
+	// The largest lower bound on the steps from -> to that the landmarks give.
+	auto lower_bound(word_id from, word_id to) const noexcept -> std::size_t;
+	// The smallest upper bound, or SIZE_MAX if no landmark reaches both words.
+	auto upper_bound(word_id from, word_id to) const noexcept -> std::size_t;
+};
+
+// Pick up to count landmarks in the largest connected component of index and run a BFS from
+// each. The first is the word of that component with most neighbours, every later one the
+// word furthest from the landmarks picked so far, so the landmarks end up spread around the
+// component. An index without components counts as a single component.
+auto build_landmark_index(const neighbour_index& index, std::size_t count = 16) -> landmark_index;
+
+// Steps of the shortest ladder from -> to, by a two end BFS that keeps no parent links and
+// gives up once the ladder would be longer than limit. Empty if there is no such ladder.
+auto ladder_distance(
+    const neighbour_index& index,
+    search_state& state,
+    word_id from,
+    word_id to,
+    std::size_t limit = SIZE_MAX) -> std::optional<std::size_t>;
+
+// Same as ladder_distance, but settled from the landmark bounds whenever they agree, and
+// otherwise searched only up to the upper bound.
+auto landmark_distance(
+    const neighbour_index& index,
+    const landmark_index& landmarks,
+    search_state& state,
+    word_id from,
+    word_id to,
+    std::size_t limit = SIZE_MAX) -> std::optional<std::size_t>;
+
+// Costs of the steps of a weighted ladder: changing code point a into code point b costs
+// letters.at({a, b}) if present and default_cost otherwise. Every cost must be positive.
+struct substitution_costs {
+	double default_cost = 1.0;
+	std::map<std::pair<char32_t, char32_t>, double> letters;
+
+	auto cost(char32_t from, char32_t to) const -> double;
+	// The smallest cost of any step, whatever the lexicon.
+	auto cheapest() const noexcept -> double;
+};
+
+// The distinct code points that occur at each position of the words of index, sorted.
+// Buckets already only offer the letters that occur with the rest of a word held fixed,
+// which is never more than these; best_ladder uses them to ignore costs of substitutions
+// no word of the index can make. They only depend on the index, so compute them once.
+auto position_alphabets(const neighbour_index& index) -> std::vector<std::vector<char32_t>>;
+
+// One cheapest ladder, as found by best_ladder.
+struct weighted_ladder {
+	// Empty if there is no ladder.
+	std::vector<std::string> words;
+	double cost = 0;
+	// Words taken off the open list and expanded, to compare against a two end BFS.
+	std::size_t expanded = 0;
+};
+
+// A* search for a single cheapest ladder from -> to under costs.
+// Every step changes one letter, so the Hamming distance to `to`, in code points, times the
+// cheapest step the index allows never overestimates the cost left; the search expands words
+// in order of cost so far plus that estimate, from a binary heap, and stops as soon as `to`
+// comes off the heap.
+// Ties go to the word closest to `to`, then to the smallest word.
+// Preconditions:
+// - index.length == code_points(from)
+auto best_ladder(
+    const std::string& from,
+    const std::string& to,
+    const neighbour_index& index,
+    const substitution_costs& costs = {}) -> weighted_ladder;
+// Same as above, with the position_alphabets of index computed beforehand. They are only
+// read when costs lists letters.
+auto best_ladder(
+    const std::string& from,
+    const std::string& to,
+    const neighbour_index& index,
+    const substitution_costs& costs,
+    std::span<const std::vector<char32_t>> alphabets) -> weighted_ladder;
+
+// How a solver turns the words of a query into word ids.
+enum class dictionary_backend {
+	// A std::unordered_map from word to id per length, like the string set of filtered_dict.
+	hash_set,
+	// Binary search over the sorted words of an index, with fixed-width compares when ASCII.
+	// Needs no memory beyond the index itself.
+	sorted_array,
+	// The minimal perfect hash of an index: one probe and one compare.
+	perfect_hash,
+};
+
+// Answers many ladder queries against one lexicon.
+// The lexicon is preprocessed once into a neighbour index per word length, and the search
+// buffers of each length are kept between queries, so a query only pays for the words it
+// visits even when lengths alternate.
+// A solver is not safe to query from several threads at once.
+class solver {
+ public:
+	explicit solver(
+	    const std::unordered_set<std::string>& lexicon,
+	    dictionary_backend backend = dictionary_backend::perfect_hash);
+	// Use prebuilt indices, indexed by word length, e.g. the result of map_lexicon.
+	explicit solver(
+	    std::vector<neighbour_index> indices,
+	    dictionary_backend backend = dictionary_backend::perfect_hash);
+
+	// Expand large frontiers of a single query across threads threads (1 turns it off).
+	// Affects generate, stream and solve_batch, which share the solver's search states.
+	// solve_batch_parallel ignores it, since it already runs one query per worker.
+	void set_expand_threads(std::size_t threads) noexcept;
+
+	// Choose how generate, stream and solve_batch find neighbours; solve_batch_parallel
+	// always walks buckets.
+	void set_expansion_mode(expansion_mode mode) noexcept;
+	// Choose how generate, stream and solve_batch pick the end to expand;
+	// solve_batch_parallel always uses expansion_cost.
+	void set_direction_policy(direction_policy policy) noexcept;
+	// The state of the last search run by generate or stream, e.g. to inspect its steps.
+	auto last_search() const noexcept -> const search_state&;
+
+	// Keep the ladders of the last capacity distinct (from, to) pairs passed to generate,
+	// evicting the least recently used pair first. A query whose reverse is cached is
+	// served by reversing the cached ladders. 0, the default, turns the cache off.
+	// Streams and batches neither read nor fill the cache.
+	void set_cache_capacity(std::size_t capacity);
+	// Number of generate calls served from the cache, and calls that had to search.
+	auto cache_hits() const noexcept -> std::size_t;
+	auto cache_misses() const noexcept -> std::size_t;
+
+	// Same as word_ladder::generate, against the solver's lexicon.
+	auto generate(const std::string& from, const std::string& to) -> std::vector<std::vector<std::string>>;
+	// Steps of the shortest ladder from -> to (one less than its number of words), or
+	// empty for an unknown word or unreachable pair. The landmark index of a word length
+	// is built by the first query of that length.
+	auto distance(const std::string& from, const std::string& to) -> std::optional<std::size_t>;
+	// Same as word_ladder::best_ladder, against the solver's lexicon.
+	auto best_ladder(const std::string& from, const std::string& to, const substitution_costs& costs = {}) const
+	    -> weighted_ladder;
+	// Whether some ladder from -> to takes at most steps steps.
+	auto reachable_within(const std::string& from, const std::string& to, std::size_t steps) -> bool;
+
+	// Same as word_ladder::stream_ladders, against the solver's lexicon.
+	// The stream refers to the solver's index, so the solver must outlive it.
+	auto stream(const std::string& from, const std::string& to) -> ladder_stream;
+	// Solve every (from, to) query, returning the ladders of queries[i] at position i.
+	// Queries are solved grouped by word length so each group walks a single index.
+	auto solve_batch(std::span<const std::pair<std::string, std::string>> queries)
+	    -> std::vector<std::vector<std::vector<std::string>>>;
+	// Same as solve_batch, spread over threads workers with their own search scratch space.
+	// Each worker starts on a contiguous run of the length sorted queries and, once it runs
+	// dry, steals queries from the far end of the busiest remaining run.
+	// threads == 0 means one worker per hardware thread.
+	auto solve_batch_parallel(std::span<const std::pair<std::string, std::string>> queries, std::size_t threads = 0) const
+	    -> std::vector<std::vector<std::vector<std::string>>>;
+
+	// The index of all words of the given length; empty if there are none.
+	auto index(std::size_t length) const noexcept -> const neighbour_index&;
+	// The id of word in the index of its length, looked up through the solver's backend.
+	auto find(std::string_view word) const -> std::optional<word_id>;
+	auto backend() const noexcept -> dictionary_backend;
+
+ private:
+	// Search from -> to with the given scratch state and build its ladder DAG.
+	// Returns false if a word is unknown or the pair is unreachable.
+	auto search(const std::string& from, const std::string& to, search_state& state, ladder_dag& dag) const -> bool;
+	// The search state for words of length code points, with the solver's settings applied.
+	// Built by the first query of that length; lengths with no index share one state.
+	auto state_for(std::size_t length) -> search_state&;
+	// Order of queries with words of equal length next to each other.
+	static auto length_order(std::span<const std::pair<std::string, std::string>> queries) -> std::vector<std::size_t>;
+	// Same as distance, giving up beyond limit steps.
+	auto bounded_distance(const std::string& from, const std::string& to, std::size_t limit)
+	    -> std::optional<std::size_t>;
+	// Move the cached entry of (from, to) to the front and return it, or nullptr if absent.
+	auto cached(const std::string& from, const std::string& to) -> const std::vector<std::vector<std::string>>*;
+
+	using query = std::pair<std::string, std::string>;
+	struct query_hash {
+		auto operator()(const query& q) const noexcept -> std::size_t;
+	};
+	using cache_entry = std::pair<query, std::vector<std::vector<std::string>>>;
+
+	std::vector<neighbour_index> _indices;
+	dictionary_backend _backend;
+	// Word to id maps of the hash_set backend, indexed by length; empty for other backends.
+	std::vector<std::unordered_map<std::string_view, word_id>> _hash_sets;
+	neighbour_index _empty;
+	// Search states by word length, built on demand by state_for, and the state of the last
+	// generate or stream, null before the first.
+	std::vector<std::unique_ptr<search_state>> _states;
+	const search_state* _last_state = nullptr;
+	// Workers of the last parallel search, handed to every state so lengths share one pool.
+	std::shared_ptr<expand_pool> _workers;
+	direction_policy _policy = direction_policy::expansion_cost;
+	expansion_mode _expansion = expansion_mode::buckets;
+	std::size_t _expand_threads = 1;
+	ladder_dag _dag;
+	// position_alphabets of every index, indexed by length, for best_ladder.
+	std::vector<std::vector<std::vector<char32_t>>> _alphabets;
+	// Landmark indices by length, built on demand; an index with no words is not built yet.
+	std::vector<landmark_index> _landmarks;
+	// Cached results, most recently used first, and where each query sits in that list.
+	std::size_t _cache_capacity = 0;
+	std::list<cache_entry> _cache;
+	std::unordered_map<query, std::list<cache_entry>::iterator, query_hash> _cache_slots;
+	std::size_t _cache_hits = 0;
+	std::size_t _cache_misses = 0;
+};
 } // namespace word_ladder
 #endif // COMP6771_WORD_LADDER_H
@@ -2,6 +2,8 @@
 
 #include <catch2/catch.hpp>
 
+#include <ranges>
+
 TEST_CASE("at -> it") {
 	auto const lexicon = std::unordered_set<std::string>{
 		"at",
@@ -49,6 +51,21 @@ TEST_CASE("ab->cd (no connected word)") {
 	CHECK(ladders == expected);
 }
 
+TEST_CASE("work -> work (a word is no ladder to itself)") {
+	auto const lexicon = ::word_ladder::read_lexicon("./english.txt");
+	CHECK(word_ladder::generate("work", "work", lexicon).empty());
+	CHECK(word_ladder::generate("atlases", "atlases", lexicon).empty());
+	CHECK(word_ladder::generate("work", "work", word_ladder::build_neighbour_index(4, lexicon)).empty());
+
+	auto solver = word_ladder::solver(lexicon);
+	CHECK(solver.generate("cat", "cat").empty());
+	auto const queries = std::vector<std::pair<std::string, std::string>>{{"work", "work"}, {"cat", "dog"}};
+	auto const results = solver.solve_batch(queries);
+	CHECK(results[0].empty());
+	CHECK(results[1] == word_ladder::generate("cat", "dog", lexicon));
+	CHECK(solver.solve_batch_parallel(queries, 2) == results);
+}
+
 TEST_CASE("work -> play (only one way success)") {
 	auto const lexicon = std::unordered_set<std::string>{
 		"work", 
@@ -189,3 +206,664 @@ TEST_CASE("work -> play (12 ways success)") {
 	} 
 	CHECK(ladders == expected);
 }
+
+TEST_CASE("neighbour index reused across queries") {
+	auto const lexicon = ::word_ladder::read_lexicon("./english.txt");
+	auto const index = ::word_ladder::build_neighbour_index(4, lexicon);
+
+	CHECK(index.length == 4);
+	for (word_ladder::word_id id = 1; id < index.size(); ++id) {
+		CHECK(index.word(id - 1) < index.word(id));
+	}
+	auto const code = *index.find("code");
+	CHECK(index.word(code) == "code");
+	CHECK(!index.find("qqqq"));
+	CHECK(!index.find("codes"));
+	for (auto neighbour : index.bucket(code, 1)) {
+		CHECK(index.word(neighbour)[0] == 'c');
+		CHECK(index.word(neighbour).substr(2) == "de");
+	}
+	CHECK(index.bucket(code, 1).size() > 1);
+
+	auto const work_play = word_ladder::generate("work", "play", index);
+	CHECK(work_play == word_ladder::generate("work", "play", lexicon));
+	CHECK(work_play.size() == 12);
+
+	auto const code_data = word_ladder::generate("code", "data", index);
+	CHECK(code_data == word_ladder::generate("code", "data", lexicon));
+	CHECK(code_data.front().front() == "code");
+	CHECK(code_data.front().back() == "data");
+
+	// One search state kept across queries gives the same ladders.
+	auto state = word_ladder::search_state{};
+	for (int i = 0; i < 2; ++i) {
+		CHECK(word_ladder::generate("work", "play", index, state) == work_play);
+		CHECK(word_ladder::generate("code", "data", index, state) == code_data);
+		CHECK(word_ladder::generate("code", "qqqq", index, state).empty());
+	}
+
+	// A buckets only index has the same words and buckets, without the lookup extras.
+	auto const light = ::word_ladder::build_neighbour_index(4, lexicon, word_ladder::index_parts::buckets);
+	CHECK(light.hash_displacements.empty());
+	CHECK(light.packed.empty());
+	CHECK(light.components.empty());
+	CHECK(std::ranges::equal(light.text, index.text));
+	CHECK(std::ranges::equal(light.bucket_words, index.bucket_words));
+	CHECK(std::ranges::equal(light.word_buckets, index.word_buckets));
+	CHECK(light.find("code") == code);
+	CHECK(!light.find("qqqq"));
+	CHECK(word_ladder::generate("work", "play", light) == work_play);
+}
+
+TEST_CASE("cat -> dog (ladders sharing words)") {
+	auto const lexicon = std::unordered_set<std::string>{
+		"cat",
+		"cot",
+		"cog",
+		"dot",
+		"dog",
+		"bat",
+		"bot",
+		"bog"
+	};
+
+	const auto expected = std::vector<std::vector<std::string>>{
+		{"cat", "cot", "cog", "dog"},
+		{"cat", "cot", "dot", "dog"}
+	};
+
+	auto const ladders = word_ladder::generate("cat", "dog", lexicon);
+	CHECK(ladders == expected);
+}
+
+TEST_CASE("work -> play (streamed lazily in lexicographic order)") {
+	auto const lexicon = ::word_ladder::read_lexicon("./english.txt");
+	auto const index = ::word_ladder::build_neighbour_index(4, lexicon);
+	auto const all = word_ladder::generate("work", "play", index);
+
+	auto stream = word_ladder::stream_ladders("work", "play", index);
+	STATIC_REQUIRE(std::ranges::input_range<decltype(stream)>);
+	auto first = std::vector<std::vector<std::string>>{};
+	for (const auto &ladder : stream | std::views::take(3)) {
+		first.push_back(ladder);
+	}
+	CHECK(first.size() == 3);
+	CHECK(first == std::vector<std::vector<std::string>>(all.begin(), all.begin() + 3));
+	CHECK(std::is_sorted(all.begin(), all.end()));
+
+	// Many ladders come out in order and without repeats, with no sort at the end.
+	auto const many = word_ladder::generate("atlases", "cabaret", lexicon);
+	CHECK(many.size() > 100);
+	CHECK(std::adjacent_find(many.begin(), many.end(), [](const auto& a, const auto& b) {
+		return !word_ladder::less_comparator(a, b);
+	}) == many.end());
+
+	auto none = word_ladder::stream_ladders("work", "zzzz", index);
+	CHECK(none.begin() == none.end());
+}
+
+TEST_CASE("solver answers a batch grouped by word length") {
+	auto const lexicon = ::word_ladder::read_lexicon("./english.txt");
+	auto solver = word_ladder::solver(lexicon);
+	CHECK(solver.index(4).length == 4);
+	CHECK(solver.index(4).size() == 3862);
+	CHECK(solver.index(100).size() == 0);
+
+	auto const queries = std::vector<std::pair<std::string, std::string>>{
+		{"work", "play"},
+		{"code", "data"},
+		{"fly", "sky"},
+		{"work", "play"},
+		{"at", "it"},
+		{"ab", "cd"},
+		{"work", "plays"},
+		{"code", "qqqq"}
+	};
+	auto const results = solver.solve_batch(queries);
+	CHECK(results.size() == queries.size());
+	for (std::size_t i = 0; i < 6; ++i) {
+		CHECK(results[i] == word_ladder::generate(queries[i].first, queries[i].second, lexicon));
+	}
+	CHECK(results[0].size() == 12);
+	CHECK(results[0] == results[3]);
+	CHECK(results[6].empty());
+	CHECK(results[7].empty());
+	CHECK(solver.generate("work", "play") == results[0]);
+}
+
+TEST_CASE("parallel batch matches the serial batch") {
+	auto const lexicon = ::word_ladder::read_lexicon("./english.txt");
+	auto const solver = word_ladder::solver(lexicon);
+	auto queries = std::vector<std::pair<std::string, std::string>>{};
+	for (auto const& [from, to] : std::vector<std::pair<std::string, std::string>>{
+	         {"work", "play"},
+	         {"code", "data"},
+	         {"fly", "sky"},
+	         {"at", "it"},
+	         {"cat", "dog"},
+	         {"awake", "sleep"},
+	         {"hello", "world"},
+	         {"code", "qqqq"}}) {
+		for (int i = 0; i < 5; ++i) {
+			queries.emplace_back(from, to);
+		}
+	}
+
+	auto serial = word_ladder::solver(lexicon);
+	auto const expected = serial.solve_batch(queries);
+	CHECK(solver.solve_batch_parallel(queries, 4) == expected);
+	CHECK(solver.solve_batch_parallel(queries, 1) == expected);
+	CHECK(solver.solve_batch_parallel(queries, 100) == expected);
+	CHECK(solver.solve_batch_parallel(queries) == expected);
+	CHECK(solver.solve_batch_parallel({}, 4).empty());
+}
+
+TEST_CASE("parallel frontier expansion matches the serial search") {
+	auto const lexicon = ::word_ladder::read_lexicon("./english.txt");
+	auto const index = ::word_ladder::build_neighbour_index(7, lexicon);
+	auto const from = *index.find("atlases");
+	auto const to = *index.find("cabaret");
+
+	auto serial = word_ladder::search_state{};
+	word_ladder::start_search(index, serial, from, to);
+	word_ladder::two_end_bfs(index, serial);
+
+	auto parallel = word_ladder::search_state{};
+	parallel.expand_threads = 3;
+	parallel.parallel_min_frontier = 1;
+	word_ladder::start_search(index, parallel, from, to);
+	word_ladder::two_end_bfs(index, parallel);
+
+	CHECK(!serial.meetings.empty());
+	CHECK(parallel.meetings == serial.meetings);
+	CHECK(parallel.visited == serial.visited);
+	CHECK(parallel.parents == serial.parents);
+
+	// The workers started by the first parallel level serve the later levels and queries.
+	auto const* workers = parallel.workers.get();
+	REQUIRE(workers != nullptr);
+	word_ladder::start_search(index, parallel, to, from);
+	word_ladder::two_end_bfs(index, parallel);
+	word_ladder::start_search(index, parallel, from, to);
+	word_ladder::two_end_bfs(index, parallel);
+	CHECK(parallel.workers.get() == workers);
+	CHECK(parallel.meetings == serial.meetings);
+	CHECK(parallel.parents == serial.parents);
+
+	auto solver = word_ladder::solver(lexicon);
+	auto const expected = solver.generate("atlases", "cabaret");
+	solver.set_expand_threads(4);
+	CHECK(solver.generate("atlases", "cabaret") == expected);
+}
+
+TEST_CASE("compiled lexicon round trip through a memory mapped file") {
+	auto const lexicon = ::word_ladder::read_lexicon("./english.txt");
+	auto const built = ::word_ladder::build_neighbour_indices(lexicon);
+	::word_ladder::save_lexicon("./english.wldx", built);
+	auto const mapped = ::word_ladder::map_lexicon("./english.wldx");
+
+	REQUIRE(mapped.size() == built.size());
+	auto words = std::size_t{0};
+	for (std::size_t length = 0; length < mapped.size(); ++length) {
+		CHECK(mapped[length].length == length);
+		CHECK(mapped[length].size() == built[length].size());
+		for (word_ladder::word_id id = 0; id < mapped[length].size(); ++id) {
+			CHECK(mapped[length].word(id) == built[length].word(id));
+			CHECK(mapped[length].find(built[length].word(id)) == id);
+			CHECK(mapped[length].components[id] == built[length].components[id]);
+		}
+		words += mapped[length].size();
+	}
+	CHECK(words == lexicon.size());
+
+	auto solver = word_ladder::solver(::word_ladder::map_lexicon("./english.wldx"));
+	CHECK(solver.generate("work", "play") == word_ladder::generate("work", "play", lexicon));
+	CHECK(solver.generate("atlases", "cabaret") == word_ladder::generate("atlases", "cabaret", lexicon));
+
+	CHECK_THROWS_AS(::word_ladder::map_lexicon("./no_such_file.wldx"), std::runtime_error);
+	CHECK_THROWS_AS(::word_ladder::map_lexicon("./english.txt"), std::runtime_error);
+
+	// A buckets only index lacks the lookup table and labels a compiled lexicon carries.
+	auto threes = std::vector<std::string_view>{};
+	for (auto const& word : lexicon) {
+		if (word.size() == 3) threes.emplace_back(word);
+	}
+	auto const buckets_only = std::vector<word_ladder::neighbour_index>{
+	    word_ladder::build_neighbour_index(3, threes, word_ladder::index_parts::buckets)};
+	CHECK_THROWS_AS(::word_ladder::save_lexicon("./buckets_only.wldx", buckets_only), std::runtime_error);
+	CHECK(!std::ifstream("./buckets_only.wldx").is_open());
+
+	// A copy with any four bytes overwritten is either rejected, or every lookup of it stays
+	// inside its arrays.
+	auto const small = word_ladder::build_neighbour_indices(std::unordered_set<std::string>{"cat", "cot", "cog", "dog"});
+	word_ladder::save_lexicon("./small.wldx", small);
+	auto in = std::ifstream("./small.wldx", std::ios::binary | std::ios::ate);
+	auto good = std::string(static_cast<std::size_t>(in.tellg()), '\0');
+	in.seekg(0);
+	in.read(good.data(), static_cast<std::streamsize>(good.size()));
+	auto rejected = std::size_t{0};
+	for (std::size_t at = 0; at + 4 <= good.size(); at += 4) {
+		auto bad = good;
+		bad.replace(at, 4, "\xff\xff\xff\x7f");
+		std::ofstream("./corrupt.wldx", std::ios::binary | std::ios::trunc) << bad;
+		auto indices = std::vector<word_ladder::neighbour_index>{};
+		try {
+			indices = word_ladder::map_lexicon("./corrupt.wldx");
+		} catch (const std::runtime_error&) {
+			++rejected;
+			continue;
+		}
+		for (auto const& index : indices) {
+			for (word_ladder::word_id id = 0; id < index.size(); ++id) {
+				auto const word = index.word(id);
+				CHECK((word.data() >= index.text.data() && word.data() + word.size() <= index.text.data() + index.text.size()));
+				for (std::size_t pos = 0; pos < index.length; ++pos) {
+					auto const bucket = index.bucket(id, pos);
+					CHECK((bucket.data() >= index.bucket_words.data()
+					       && bucket.data() + bucket.size() <= index.bucket_words.data() + index.bucket_words.size()));
+					CHECK(std::all_of(bucket.begin(), bucket.end(), [&](auto other) { return other < index.size(); }));
+				}
+				CHECK((!index.find(word) || *index.find(word) < index.size()));
+			}
+		}
+	}
+	CHECK(rejected > 0);
+}
+
+TEST_CASE("dictionary backends agree") {
+	auto const lexicon = ::word_ladder::read_lexicon("./english.txt");
+	auto const indices = ::word_ladder::build_neighbour_indices(lexicon);
+	auto const backends = std::vector<word_ladder::dictionary_backend>{
+		word_ladder::dictionary_backend::hash_set,
+		word_ladder::dictionary_backend::sorted_array,
+		word_ladder::dictionary_backend::perfect_hash
+	};
+	for (auto backend : backends) {
+		auto solver = word_ladder::solver(indices, backend);
+		CHECK(solver.backend() == backend);
+		for (auto const& word : lexicon) {
+			auto const id = solver.find(word);
+			REQUIRE(id);
+			CHECK(solver.index(word.size()).word(*id) == word);
+		}
+		CHECK(!solver.find("qqqq"));
+		CHECK(!solver.find("aaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaa"));
+		CHECK(!solver.find(""));
+		CHECK(solver.generate("work", "play") == word_ladder::generate("work", "play", lexicon));
+	}
+}
+
+TEST_CASE("packed scan finds the same ladders as bucket walks") {
+	CHECK(word_ladder::pack_word("ab") == 0b00001'00000U);
+	CHECK(!word_ladder::pack_word("Ab"));
+	CHECK(!word_ladder::pack_word("abcdefghijklm"));
+
+	auto const lexicon = ::word_ladder::read_lexicon("./english.txt");
+	auto solver = word_ladder::solver(lexicon);
+	CHECK(solver.index(12).packed.size() == solver.index(12).size());
+	CHECK(solver.index(13).packed.empty());
+
+	auto const queries = std::vector<std::pair<std::string, std::string>>{
+		{"at", "it"},
+		{"fly", "sky"},
+		{"work", "play"},
+		{"awake", "sleep"},
+		{"atlases", "cabaret"},
+		{"dog", "hot"}
+	};
+	for (auto const& [from, to] : queries) {
+		solver.set_expansion_mode(word_ladder::expansion_mode::buckets);
+		auto const expected = solver.generate(from, to);
+		solver.set_expansion_mode(word_ladder::expansion_mode::packed_scan);
+		CHECK(solver.generate(from, to) == expected);
+	}
+	solver.set_expand_threads(2);
+	CHECK(solver.generate("atlases", "cabaret") == word_ladder::generate("atlases", "cabaret", lexicon));
+}
+
+TEST_CASE("word bitset marks and scans word ids") {
+	auto set = word_ladder::word_bitset{};
+	set.reset(130);
+	CHECK(set.size() == 130);
+	CHECK(set.blocks() == 3);
+	for (word_ladder::word_id id : {129U, 0U, 64U, 63U, 5U}) {
+		set.set(id);
+	}
+	CHECK(set.test(63));
+	CHECK(!set.test(62));
+
+	auto ids = std::vector<word_ladder::word_id>{};
+	set.for_each([&](word_ladder::word_id id) { ids.push_back(id); });
+	CHECK(ids == std::vector<word_ladder::word_id>{0, 5, 63, 64, 129});
+	ids.clear();
+	set.for_each([&](word_ladder::word_id id) { ids.push_back(id); }, 1, 2);
+	CHECK(ids == std::vector<word_ladder::word_id>{64});
+
+	set.clear();
+	CHECK(set.size() == 130);
+	CHECK(!set.test(129));
+}
+
+TEST_CASE("direction policies find the same ladders and record their steps") {
+	auto const lexicon = word_ladder::read_lexicon("./english.txt");
+	auto solver = word_ladder::solver(lexicon);
+	auto const& index = solver.index(3);
+	auto const cat = index.find("cat");
+	REQUIRE(cat.has_value());
+	auto degree = std::size_t{0};
+	for (std::size_t pos = 0; pos < 3; ++pos) {
+		degree += index.bucket(*cat, pos).size() - 1;
+	}
+	CHECK(index.degree(*cat) == degree);
+
+	for (auto const& [from, to] : std::vector<std::pair<std::string, std::string>>{
+	         {"cat", "dog"}, {"work", "play"}, {"awake", "sleep"}, {"atlases", "cabaret"}}) {
+		solver.set_direction_policy(word_ladder::direction_policy::frontier_size);
+		auto const expected = solver.generate(from, to);
+		solver.set_direction_policy(word_ladder::direction_policy::expansion_cost);
+		CHECK(solver.generate(from, to) == expected);
+
+		auto const& steps = solver.last_search().steps;
+		REQUIRE(!steps.empty());
+		for (auto const& step : steps) {
+			auto const expanded = step.expanded_from_side ? step.from_cost : step.to_cost;
+			auto const other = step.expanded_from_side ? step.to_cost : step.from_cost;
+			CHECK(expanded <= other);
+		}
+	}
+}
+
+TEST_CASE("solver cache serves repeated and reversed queries") {
+	auto const lexicon = word_ladder::read_lexicon("./english.txt");
+	auto solver = word_ladder::solver(lexicon);
+	auto const expected = solver.generate("work", "play");
+	auto const reversed = solver.generate("play", "work");
+	auto const unreachable = solver.generate("airplane", "tricycle");
+	CHECK(solver.cache_hits() == 0);
+	CHECK(solver.cache_misses() == 0);
+
+	solver.set_cache_capacity(2);
+	CHECK(solver.generate("work", "play") == expected);
+	CHECK(solver.cache_misses() == 1);
+	CHECK(solver.generate("work", "play") == expected);
+	CHECK(solver.generate("play", "work") == reversed);
+	CHECK(solver.cache_hits() == 2);
+
+	CHECK(solver.generate("airplane", "tricycle") == unreachable);
+	CHECK(solver.generate("cat", "dog") == word_ladder::generate("cat", "dog", lexicon));
+	CHECK(solver.cache_misses() == 3);
+	// work -> play was the least recently used pair, so it was evicted by cat -> dog.
+	CHECK(solver.generate("play", "work") == reversed);
+	CHECK(solver.cache_misses() == 4);
+	CHECK(solver.generate("tricycle", "airplane") == unreachable);
+	CHECK(solver.cache_misses() == 5);
+	CHECK(solver.cache_hits() == 2);
+
+	// Batches go around the cache.
+	auto const cat_dog = word_ladder::generate("cat", "dog", lexicon);
+	auto const batch = std::vector<std::pair<std::string, std::string>>{{"tricycle", "airplane"}, {"cat", "dog"}};
+	CHECK(solver.solve_batch(batch) == std::vector<std::vector<std::vector<std::string>>>{unreachable, cat_dog});
+	CHECK(solver.cache_hits() == 2);
+	CHECK(solver.cache_misses() == 5);
+	CHECK(solver.generate("cat", "dog") == cat_dog);
+	CHECK(solver.cache_misses() == 6);
+
+	solver.set_cache_capacity(0);
+	CHECK(solver.generate("play", "work") == reversed);
+	CHECK(solver.cache_hits() == 2);
+	CHECK(solver.cache_misses() == 6);
+}
+
+TEST_CASE("component labels reject unreachable pairs up front") {
+	auto const lexicon = word_ladder::read_lexicon("./english.txt");
+	auto const index = word_ladder::build_neighbour_index(8, lexicon);
+	REQUIRE(index.components.size() == index.size());
+	auto const airplane = index.find("airplane");
+	auto const tricycle = index.find("tricycle");
+	REQUIRE(airplane.has_value());
+	REQUIRE(tricycle.has_value());
+	CHECK(!index.connected(*airplane, *tricycle));
+	CHECK(index.connected(*airplane, *airplane));
+	CHECK(word_ladder::generate("airplane", "tricycle", index).empty());
+
+	// Every word shares the label of each of its neighbours, and label 0 is the first word's.
+	auto const small = word_ladder::build_neighbour_index(3, lexicon);
+	CHECK(small.components[0] == 0);
+	for (word_ladder::word_id id = 0; id < small.size(); ++id) {
+		for (std::size_t pos = 0; pos < 3; ++pos) {
+			for (auto other : small.bucket(id, pos)) {
+				CHECK(small.components[other] == small.components[id]);
+			}
+		}
+	}
+	auto const cat = small.find("cat");
+	auto const dog = small.find("dog");
+	CHECK(small.connected(*cat, *dog));
+}
+
+TEST_CASE("distance queries agree with the ladders") {
+	auto const lexicon = word_ladder::read_lexicon("./english.txt");
+	auto solver = word_ladder::solver(lexicon);
+	for (auto const& [from, to] : std::vector<std::pair<std::string, std::string>>{
+	         {"at", "it"}, {"cat", "dog"}, {"work", "play"}, {"awake", "sleep"}, {"atlases", "cabaret"}}) {
+		auto const ladders = solver.generate(from, to);
+		REQUIRE(!ladders.empty());
+		auto const steps = ladders.front().size() - 1;
+		CHECK(solver.distance(from, to) == steps);
+		CHECK(solver.distance(to, from) == steps);
+		CHECK(solver.reachable_within(from, to, steps));
+		CHECK(!solver.reachable_within(from, to, steps - 1));
+	}
+	CHECK(solver.distance("cat", "cat") == 0);
+	CHECK(solver.distance("airplane", "tricycle") == std::nullopt);
+	CHECK(solver.distance("cat", "zzz") == std::nullopt);
+	CHECK(!solver.reachable_within("airplane", "tricycle", 100));
+
+	auto const index = word_ladder::build_neighbour_index(4, lexicon);
+	auto const landmarks = word_ladder::build_landmark_index(index, 4);
+	CHECK(landmarks.landmarks.size() == 4);
+	auto state = word_ladder::search_state{};
+	auto const work = *index.find("work");
+	auto const play = *index.find("play");
+	auto const exact = word_ladder::ladder_distance(index, state, work, play);
+	REQUIRE(exact.has_value());
+	CHECK(landmarks.lower_bound(work, play) <= *exact);
+	CHECK(landmarks.upper_bound(work, play) >= *exact);
+	CHECK(word_ladder::landmark_distance(index, landmarks, state, work, play) == exact);
+	CHECK(word_ladder::ladder_distance(index, state, work, play, *exact - 1) == std::nullopt);
+
+	// Among eight letter words the best connected word is not in the largest component,
+	// but every landmark must be.
+	auto const eights = word_ladder::build_neighbour_index(8, lexicon);
+	auto sizes = std::vector<std::size_t>{};
+	for (auto label : eights.components) {
+		sizes.resize(std::max<std::size_t>(sizes.size(), label + 1));
+		++sizes[label];
+	}
+	auto const largest = static_cast<std::uint32_t>(std::max_element(sizes.begin(), sizes.end()) - sizes.begin());
+	for (auto landmark : word_ladder::build_landmark_index(eights, 4).landmarks) {
+		CHECK(eights.components[landmark] == largest);
+	}
+}
+
+TEST_CASE("generate fills in search stats when asked to") {
+	auto const lexicon = word_ladder::read_lexicon("./english.txt");
+	auto stats = word_ladder::search_stats{};
+	auto const ladders = word_ladder::generate("work", "play", lexicon, stats);
+	CHECK(ladders == word_ladder::generate("work", "play", lexicon));
+	CHECK(stats.paths == ladders.size());
+	CHECK(stats.filter_time.count() > 0);
+	CHECK(stats.search_time.count() > 0);
+	// Every step of the ladder is one expanded level, the last one meeting the other end.
+	CHECK(stats.from_levels.size() + stats.to_levels.size() == ladders.front().size() - 1);
+	REQUIRE(!stats.from_levels.empty());
+	CHECK(stats.from_levels.front() == 1);
+	CHECK(stats.neighbours_scanned > 0);
+
+	auto const index = word_ladder::build_neighbour_index(8, lexicon);
+	CHECK(word_ladder::generate("airplane", "tricycle", index, stats).empty());
+	CHECK(stats.paths == ladders.size());
+
+	auto none = word_ladder::no_stats{};
+	CHECK(word_ladder::generate("work", "play", lexicon, none) == ladders);
+	static_assert(std::is_empty_v<word_ladder::no_stats>);
+}
+
+TEST_CASE("scratch arena grows to fit a query and is then reused") {
+	auto arena = word_ladder::scratch_arena(256);
+	CHECK(arena.capacity() == 256);
+	{
+		auto small = std::pmr::vector<int>(&arena);
+		small.resize(16);
+		CHECK(arena.spilled() == 0);
+	}
+	arena.reset();
+	{
+		auto large = std::pmr::vector<int>(&arena);
+		large.resize(1024);
+		CHECK(arena.spilled() >= 1024 * sizeof(int));
+	}
+	arena.reset();
+	CHECK(arena.spilled() == 0);
+	CHECK(arena.capacity() >= 256 + 1024 * sizeof(int));
+	{
+		auto large = std::pmr::vector<int>(&arena);
+		large.resize(1024);
+		CHECK(arena.spilled() == 0);
+	}
+
+	// A solver's searches run out of the arena of its state and keep their answers.
+	auto const lexicon = word_ladder::read_lexicon("./english.txt");
+	auto solver = word_ladder::solver(lexicon);
+	auto const expected = word_ladder::generate("work", "play", lexicon);
+	for (int i = 0; i < 3; ++i) {
+		CHECK(solver.generate("work", "play") == expected);
+		CHECK(solver.generate("awake", "sleep") == word_ladder::generate("awake", "sleep", lexicon));
+	}
+	CHECK(solver.last_search().arena->capacity() >= 64 * 1024);
+
+	// Each word length keeps its own state, so alternating lengths reuse both.
+	auto const* fives = &solver.last_search();
+	CHECK(solver.generate("work", "play") == expected);
+	auto const* fours = &solver.last_search();
+	CHECK(fours != fives);
+	CHECK(fours->parents.size() == solver.index(4).size());
+	CHECK(solver.generate("awake", "sleep") == word_ladder::generate("awake", "sleep", lexicon));
+	CHECK(&solver.last_search() == fives);
+	CHECK(fives->parents.size() == solver.index(5).size());
+	CHECK(solver.generate("work", "play") == expected);
+	CHECK(&solver.last_search() == fours);
+}
+
+TEST_CASE("edit ladders may insert and delete letters") {
+	auto const lexicon = std::unordered_set<std::string>{"a", "at", "bat", "cat", "car", "cart", "card", "aab", "ab"};
+	auto const index = word_ladder::build_edit_index(lexicon);
+	CHECK(index.size() == lexicon.size());
+	auto const cat = *index.find("cat");
+	auto neighbours = std::vector<std::string>{};
+	for (auto id : index.neighbours_of(cat)) {
+		neighbours.emplace_back(index.word(id));
+	}
+	CHECK(neighbours == std::vector<std::string>{"at", "bat", "car", "cart"});
+	// "aab" is "ab" plus an a at either of two places, but only one step from it.
+	CHECK(index.degree(*index.find("aab")) == 1);
+
+	CHECK(word_ladder::generate_edit_ladders("cat", "card", index)
+	      == std::vector<std::vector<std::string>>{{"cat", "car", "card"}, {"cat", "cart", "card"}});
+	CHECK(word_ladder::generate_edit_ladders("a", "cat", lexicon)
+	      == std::vector<std::vector<std::string>>{{"a", "at", "cat"}});
+	CHECK(word_ladder::generate_edit_ladders("cat", "aab", index)
+	      == std::vector<std::vector<std::string>>{{"cat", "at", "ab", "aab"}});
+	CHECK(word_ladder::generate_edit_ladders("cat", "dog", index).empty());
+	CHECK(word_ladder::generate_edit_ladders("cat", "cat", index).empty());
+	CHECK(word_ladder::generate_edit_ladders("cat", "cat", {"cat", "cot", "cog", "dog", "at", "it"}).empty());
+
+	// A copy finds words on its own, even once the index it was copied from is gone.
+	auto copy = word_ladder::edit_index{};
+	{
+		auto const source = word_ladder::build_edit_index(
+		    std::unordered_set<std::string>{"antidisestablishment", "antidisestablishmentarian"});
+		copy = source;
+	}
+	CHECK(copy.find("antidisestablishment") == word_ladder::word_id{0});
+	CHECK(copy.find("antidisestablishmentarian") == word_ladder::word_id{1});
+	CHECK(!copy.find("antidisestablishmentaria"));
+
+	// Same length ladders can only get shorter when insertions and deletions are allowed.
+	auto const english = word_ladder::read_lexicon("./english.txt");
+	auto const edits = word_ladder::build_edit_index(english);
+	auto const ladders = word_ladder::generate_edit_ladders("work", "play", edits);
+	REQUIRE(!ladders.empty());
+	CHECK(ladders.front().size() <= word_ladder::generate("work", "play", english).front().size());
+	CHECK(std::is_sorted(ladders.begin(), ladders.end()));
+}
+
+TEST_CASE("best ladder finds one cheapest ladder with A*") {
+	auto const lexicon = word_ladder::read_lexicon("./english.txt");
+	auto const solver = word_ladder::solver(lexicon);
+	for (auto const& [from, to] : std::vector<std::pair<std::string, std::string>>{
+	         {"cat", "dog"}, {"work", "play"}, {"awake", "sleep"}, {"atlases", "cabaret"}}) {
+		auto const all = word_ladder::generate(from, to, lexicon);
+		auto const best = solver.best_ladder(from, to);
+		CHECK(std::find(all.begin(), all.end(), best.words) != all.end());
+		CHECK(best.cost == static_cast<double>(all.front().size() - 1));
+		CHECK(best.expanded > 0);
+	}
+	CHECK(solver.best_ladder("airplane", "tricycle").words.empty());
+	CHECK(solver.best_ladder("cat", "zzz").words.empty());
+
+	// Going straight from a to o is dear, so it pays to go round through another vowel.
+	auto costs = word_ladder::substitution_costs{};
+	costs.letters[{'a', 'o'}] = 5;
+	CHECK(costs.cheapest() == 1);
+	CHECK(solver.best_ladder("cat", "cot").words == std::vector<std::string>{"cat", "cot"});
+	auto const detour = solver.best_ladder("cat", "cot", costs);
+	CHECK(detour.cost == 2);
+	REQUIRE(detour.words.size() == 3);
+	CHECK(detour.words[1] != "cot");
+	// The solver's alphabets, computed once, give the same ladder as computing them per call.
+	auto const free = word_ladder::best_ladder("cat", "cot", solver.index(3), costs);
+	CHECK(free.words == detour.words);
+	CHECK(free.expanded == detour.expanded);
+	auto const alphabets = word_ladder::position_alphabets(solver.index(3));
+	REQUIRE(alphabets.size() == 3);
+	CHECK(alphabets[1].front() == 'a');
+	CHECK(std::is_sorted(alphabets[1].begin(), alphabets[1].end()));
+}
+
+TEST_CASE("words are compared by UTF-8 code point") {
+	auto const lexicon = std::unordered_set<std::string>{"café", "cafe", "safe", "safé", "naïf", "caf"};
+	CHECK(word_ladder::code_points("café") == 4);
+	CHECK(word_ladder::filtered_dict(4, lexicon).size() == 5);
+
+	auto const index = word_ladder::build_neighbour_index(4, lexicon);
+	CHECK(index.size() == 5);
+	CHECK(!index.word_offsets.empty());
+	CHECK(index.word(*index.find("naïf")) == "naïf");
+	CHECK(index.find_sorted("safé") == index.find("safé"));
+	CHECK(!index.find("saf").has_value());
+
+	auto const expected = std::vector<std::vector<std::string>>{{"café", "cafe", "safe"}, {"café", "safé", "safe"}};
+	CHECK(word_ladder::generate("café", "safe", lexicon) == expected);
+	CHECK(word_ladder::generate("café", "naïf", lexicon).empty());
+
+	auto const alphabets = word_ladder::position_alphabets(index);
+	REQUIRE(alphabets.size() == 4);
+	CHECK(alphabets[2] == std::vector<char32_t>{U'f', U'ï'});
+	CHECK(alphabets[3] == std::vector<char32_t>{U'e', U'f', U'é'});
+
+	auto costs = word_ladder::substitution_costs{};
+	costs.letters[{U'é', U'e'}] = 0.5;
+	auto const best = word_ladder::best_ladder("café", "safe", index, costs);
+	CHECK(best.words == expected.front());
+	CHECK(best.cost == 1.5);
+
+	CHECK(word_ladder::generate_edit_ladders("café", "caf", lexicon)
+	      == std::vector<std::vector<std::string>>{{"café", "caf"}});
+
+	auto const indices = word_ladder::build_neighbour_indices(lexicon);
+	word_ladder::save_lexicon("./unicode.wldx", indices);
+	auto const solver = word_ladder::solver(word_ladder::map_lexicon("./unicode.wldx"));
+	CHECK(solver.index(4).word(*solver.find("safé")) == "safé");
+	CHECK(solver.best_ladder("café", "safe").cost == 2);
+}
@@ -9,3 +9,48 @@ TEST_CASE("atlases -> cabaret")
 
     CHECK(std::size(ladders) != 0);
 }
+
+TEST_CASE("dictionary backend lookups")
+{
+    auto const english_lexicon = ::word_ladder::read_lexicon("./english.txt");
+    auto const indices = ::word_ladder::build_neighbour_indices(english_lexicon);
+    auto const seven = ::word_ladder::filtered_dict(7, english_lexicon);
+    auto const words = std::vector<std::string>(seven.begin(), seven.end());
+
+    BENCHMARK("filtered_dict unordered_set") {
+        auto found = std::size_t{0};
+        for (auto const& word : words) {
+            found += seven.count(word);
+        }
+        return found;
+    };
+
+    for (auto [name, backend] : {
+             std::pair{"hash_set", ::word_ladder::dictionary_backend::hash_set},
+             std::pair{"sorted_array", ::word_ladder::dictionary_backend::sorted_array},
+             std::pair{"perfect_hash", ::word_ladder::dictionary_backend::perfect_hash}}) {
+        auto const solver = ::word_ladder::solver(indices, backend);
+        BENCHMARK(name) {
+            auto found = std::size_t{0};
+            for (auto const& word : words) {
+                found += solver.find(word).has_value();
+            }
+            return found;
+        };
+    }
+}
+
+TEST_CASE("neighbour expansion modes")
+{
+    auto const english_lexicon = ::word_ladder::read_lexicon("./english.txt");
+    auto solver = ::word_ladder::solver(english_lexicon);
+
+    for (auto [name, mode] : {
+             std::pair{"fly -> sky buckets", ::word_ladder::expansion_mode::buckets},
+             std::pair{"fly -> sky packed_scan", ::word_ladder::expansion_mode::packed_scan}}) {
+        solver.set_expansion_mode(mode);
+        BENCHMARK(name) {
+            return solver.generate("fly", "sky");
+        };
+    }
+}
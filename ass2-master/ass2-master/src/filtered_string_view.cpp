@@ -91,16 +91,22 @@ namespace fsv {
 		_str = other._str;
 		_size = other._size;
 		_predicate = other._predicate;
+		_positions.store(other.share_positions(), std::memory_order_release);
+		_filtered_size.store(other._filtered_size.load(std::memory_order_relaxed), std::memory_order_relaxed);
 	}
 	filtered_string_view::filtered_string_view(filtered_string_view&& other) noexcept
 	: _str(other._str)
 	, _size(other._size)
-	, _predicate(other._predicate) {
+	, _predicate(other._predicate)
+	, _positions(other._positions.exchange(nullptr, std::memory_order_acq_rel))
+	, _filtered_size(other._filtered_size.exchange(unknown_size, std::memory_order_relaxed)) {
 		other._str = nullptr;
 		other._size = 0;
 		other._predicate = default_predicate;
 	}
-	filtered_string_view::~filtered_string_view() noexcept {}
+	filtered_string_view::~filtered_string_view() noexcept {
+		release(_positions.load(std::memory_order_acquire));
+	}
 	auto filtered_string_view::begin() const noexcept -> iterator {
 		return iter(const_cast<char*>(_str.get()), _predicate);
 	}
@@ -128,10 +134,18 @@ namespace fsv {
 	auto filtered_string_view::size() const noexcept -> std::size_t {
 		if (this->_str == nullptr)
 			return 0;
-		std::shared_ptr<char[]> predicated_str = filtered_string_view::predicate_str(this->data(), this->predicate());
-
-		std::size_t ret = std::strlen(predicated_str.get());
-		return ret;
+		auto filtered_size = _filtered_size.load(std::memory_order_relaxed);
+		if (filtered_size == unknown_size) {
+			if (auto* positions = _positions.load(std::memory_order_acquire); positions != nullptr) {
+				filtered_size = positions->offsets.size();
+			}
+			else {
+				const char* str = _str.get();
+				filtered_size = static_cast<std::size_t>(std::count_if(str, str + _size, _predicate));
+			}
+			_filtered_size.store(filtered_size, std::memory_order_relaxed);
+		}
+		return filtered_size;
 	}
 	auto operator<<(std::ostream& os, const filtered_string_view& fsv) -> std::ostream& {
 		if (fsv.data() == nullptr)
@@ -148,6 +162,8 @@ namespace fsv {
 			_str = str._str;
 			_size = str._size;
 			_predicate = str._predicate;
+			release(_positions.exchange(str.share_positions(), std::memory_order_acq_rel));
+			_filtered_size.store(str._filtered_size.load(std::memory_order_relaxed), std::memory_order_relaxed);
 		}
 		return *this;
 	}
@@ -156,68 +172,83 @@ namespace fsv {
 			this->_str = std::move(other._str);
 			this->_size = other._size;
 			this->_predicate = other._predicate;
+			release(this->_positions.exchange(other._positions.exchange(nullptr, std::memory_order_acq_rel),
+			                                  std::memory_order_acq_rel));
+			this->_filtered_size.store(other._filtered_size.exchange(unknown_size, std::memory_order_relaxed),
+			                           std::memory_order_relaxed);
 			other._size = 0;
 			other._predicate = default_predicate;
 		}
 		return *this;
 	}
 	auto operator==(const filtered_string_view& left, const filtered_string_view& right) noexcept -> bool {
-		if (left.size() != right.size())
-			return false;
-
-		for (std::size_t i = 0; i < left.size(); ++i)
-			if (left[i] != right[i])
-				return false;
-		return true;
+		return std::is_eq(left <=> right);
 	}
-	auto operator<(const filtered_string_view& left, const filtered_string_view& right) noexcept -> bool {
-		const size_t left_length = left.size();
-		const size_t right_length = right.size();
+	// <, <=, > and >= are all rewritten by the compiler in terms of this one comparison.
+	auto operator<=>(const filtered_string_view& left, const filtered_string_view& right) noexcept
+	    -> std::strong_ordering {
+		// Shorter filtered strings order first; equal lengths compare char by char.
+		if (const auto by_size = left.size() <=> right.size(); std::is_neq(by_size))
+			return by_size;
 
-		if (right_length == left_length) {
-			for (std::size_t i = 0; i < left_length; ++i)
-				if (left[i] != right[i])
-					return left[i] < right[i];
-			return false;
+		// Both strings keep exactly size() chars, so each cursor finds a kept char before running off its end.
+		const char* l = left._str.get();
+		const char* r = right._str.get();
+		for (std::size_t i = 0; i < left.size(); ++i, ++l, ++r) {
+			while (!left._predicate(*l))
+				++l;
+			while (!right._predicate(*r))
+				++r;
+			if (*l != *r)
+				return *l <=> *r;
 		}
-		else {
-			return left_length < right_length ? true : false;
-		}
-	}
-	auto operator<=(const filtered_string_view& left, const filtered_string_view& right) noexcept -> bool {
-		return left < right || left == right;
+		return std::strong_ordering::equal;
 	}
-	auto operator>(const filtered_string_view& left, const filtered_string_view& right) noexcept -> bool {
-		const size_t left_length = left.size();
-		const size_t right_length = right.size();
-
-		if (right_length == left_length) {
-			for (std::size_t i = 0; i < left_length; ++i) {
-				if (left[i] != right[i])
-					return left[i] > right[i];
+	auto filtered_string_view::filtered_positions() const -> const std::vector<std::uint32_t>& {
+		auto* published = _positions.load(std::memory_order_acquire);
+		if (published == nullptr) {
+			auto table = std::make_unique<position_table>();
+			table->offsets.reserve(size());
+			for (std::size_t i = 0; i < _size; ++i) {
+				if (_predicate(_str[static_cast<std::ptrdiff_t>(i)])) {
+					table->offsets.push_back(static_cast<std::uint32_t>(i));
+				}
 			}
-			return false;
+			// If another thread published first, published comes back holding its table.
+			if (_positions.compare_exchange_strong(published, table.get(), std::memory_order_acq_rel,
+			                                       std::memory_order_acquire)) {
+				published = table.release();
+			}
+		}
+		// _positions keeps the table alive until the view is assigned to or destroyed.
+		return published->offsets;
+	}
+	auto filtered_string_view::position(std::size_t index) const -> std::size_t {
+		if (_size <= std::numeric_limits<std::uint32_t>::max()) {
+			const auto& offsets = filtered_positions();
+			assert(index < offsets.size());
+			return offsets[index];
 		}
-		else {
-			return left_length > right_length ? true : false;
+		for (std::size_t i = 0;; ++i) {
+			if (_predicate(_str[static_cast<std::ptrdiff_t>(i)]) && index-- == 0) {
+				return i;
+			}
 		}
 	}
-	auto operator>=(const filtered_string_view& left, const filtered_string_view& right) noexcept -> bool {
-		return left > right || left == right;
+	auto filtered_string_view::share_positions() const noexcept -> position_table* {
+		auto* table = _positions.load(std::memory_order_acquire);
+		if (table != nullptr) {
+			table->refs.fetch_add(1, std::memory_order_relaxed);
+		}
+		return table;
 	}
-	auto operator<=>(const filtered_string_view& left, const filtered_string_view& right) noexcept
-	    -> std::strong_ordering {
-		if (left < right)
-			return std::strong_ordering::less;
-		if (left > right)
-			return std::strong_ordering::greater;
-		return std::strong_ordering::equal;
+	void filtered_string_view::release(position_table* table) noexcept {
+		if (table != nullptr && table->refs.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+			delete table;
+		}
 	}
 	auto filtered_string_view::operator[](std::size_t index) const noexcept -> char {
-		assert(index < _size);
-		std::shared_ptr<char[]> predicated_str = filtered_string_view::predicate_str(this->data(), this->predicate());
-		char ret = predicated_str.get()[index];
-		return ret;
+		return _str[static_cast<std::ptrdiff_t>(position(index))];
 	}
 	filtered_string_view::operator std::string() const noexcept {
 		std::string ret;
@@ -233,34 +264,14 @@ namespace fsv {
 		return _str.get();
 	}
 	auto filtered_string_view::at(int index) -> const char& {
-		if (static_cast<std::size_t>(index) >= this->size())
+		if (index < 0 || static_cast<std::size_t>(index) >= size())
 			throw std::domain_error{"filtered_string_view::at(" + std::to_string(index) + "): invalid index"};
-		auto count = 0;
-		auto predicate = this->predicate();
-
-		for (const char* ptr = _str.get(); *ptr != '\0'; ++ptr) {
-			if (predicate(*ptr)) {
-				++count;
-			}
-			if (count - 1 == index)
-				return *ptr;
-		}
-		throw std::domain_error{"filtered_string_view::at(" + std::to_string(index) + "): invalid index"};
+		return _str[static_cast<std::ptrdiff_t>(position(static_cast<std::size_t>(index)))];
 	}
 	auto filtered_string_view::at(std::size_t index) const -> const char& {
-		if (index >= this->size())
+		if (index >= size())
 			throw std::domain_error{"filtered_string_view::at(" + std::to_string(index) + "): invalid index"};
-		std::size_t count = 0;
-		auto predicate = this->predicate();
-
-		for (const char* ptr = _str.get(); *ptr != '\0'; ++ptr) {
-			if (predicate(*ptr)) {
-				++count;
-			}
-			if (count - 1 == index)
-				return *ptr;
-		}
-		throw std::domain_error{"filtered_string_view::at(" + std::to_string(index) + "): invalid index"};
+		return _str[static_cast<std::ptrdiff_t>(position(index))];
 	}
 	auto filtered_string_view::empty() noexcept -> bool {
 		return this->size() == 0 ? true : false;
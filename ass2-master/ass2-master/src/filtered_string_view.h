@@ -1,8 +1,11 @@
 #ifndef COMP6771_ASS2_FSV_H
 #define COMP6771_ASS2_FSV_H
 
+#include <algorithm>
+#include <atomic>
 #include <cassert>
 #include <compare>
+#include <cstdint>
 #include <cstring>
 #include <functional>
 #include <iostream>
@@ -12,6 +15,7 @@
 #include <optional>
 #include <set>
 #include <string>
+#include <vector>
 using filter = std::function<bool(const char&)>;
 
 /*               Design Concept
@@ -32,10 +36,6 @@ namespace fsv {
 	auto operator<<(std::ostream& os, const filtered_string_view& fsv) -> std::ostream&;
 	auto operator<<(std::ostream& os, const iter& it) -> std::ostream&;
 	auto operator==(const filtered_string_view& left, const filtered_string_view& right) noexcept -> bool;
-	auto operator<(const filtered_string_view& left, const filtered_string_view& right) noexcept -> bool;
-	auto operator<=(const filtered_string_view& left, const filtered_string_view& right) noexcept -> bool;
-	auto operator>(const filtered_string_view& left, const filtered_string_view& right) noexcept -> bool;
-	auto operator>=(const filtered_string_view& left, const filtered_string_view& right) noexcept -> bool;
 	auto operator<=>(const filtered_string_view& left, const filtered_string_view& right) noexcept
 	    -> std::strong_ordering;
 	auto compose(const filtered_string_view& fsv, const std::vector<filter>& filts) noexcept -> filtered_string_view;
@@ -69,10 +69,6 @@ namespace fsv {
 		using iterator = iter;
 		using const_iterator = const iter;
 		friend auto operator==(const filtered_string_view& left, const filtered_string_view& right) noexcept -> bool;
-		friend auto operator<(const filtered_string_view& left, const filtered_string_view& right) noexcept -> bool;
-		friend auto operator<=(const filtered_string_view& left, const filtered_string_view& right) noexcept -> bool;
-		friend auto operator>(const filtered_string_view& left, const filtered_string_view& right) noexcept -> bool;
-		friend auto operator>=(const filtered_string_view& left, const filtered_string_view& right) noexcept -> bool;
 		friend auto operator<=>(const filtered_string_view& left, const filtered_string_view& right) noexcept
 		    -> std::strong_ordering;
 		auto operator=(const filtered_string_view& str) noexcept -> filtered_string_view&;
@@ -105,9 +101,31 @@ namespace fsv {
 		static auto predicate_str(const char* str, filter predicate) noexcept -> std::shared_ptr<char[]>;
 
 	 private:
+		// Offsets in _str of the chars the predicate keeps, in order, 4 bytes each.
+		// Built on the first indexed access and shared by copies, which have the same string
+		// and predicate; the last view holding it frees it. Threads reading one view may race
+		// to build it: each builds its own, the first to publish wins, and the rest use that
+		// one. Once published, a read is a single acquire load that leaves refs alone.
+		struct position_table {
+			std::atomic<std::size_t> refs = 1;
+			std::vector<std::uint32_t> offsets;
+		};
+		auto filtered_positions() const -> const std::vector<std::uint32_t>&;
+		// Offset in _str of the index-th kept char. Strings too long for 4 byte offsets are
+		// walked instead of indexed.
+		auto position(std::size_t index) const -> std::size_t;
+		// A new reference to the published table, or nullptr if there is none yet.
+		auto share_positions() const noexcept -> position_table*;
+		static void release(position_table* table) noexcept;
+
 		std::shared_ptr<char[]> _str = nullptr;
 		std::size_t _size = 0;
 		filter _predicate = default_predicate;
+		mutable std::atomic<position_table*> _positions = nullptr;
+		// Number of chars the predicate keeps, counted without allocating on the first size().
+		// Racing threads count the same value, so a relaxed store is enough to share it.
+		static constexpr std::size_t unknown_size = std::numeric_limits<std::size_t>::max();
+		mutable std::atomic<std::size_t> _filtered_size = unknown_size;
 	};
 } // namespace fsv
 #endif // COMP6771_ASS2_FSV_H
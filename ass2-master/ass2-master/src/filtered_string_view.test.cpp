@@ -2,6 +2,8 @@
 
 #include <catch2/catch.hpp>
 
+#include <thread>
+
 TEST_CASE("Test Static Data Members") {
 	for (char c = std::numeric_limits<char>::min(); c != std::numeric_limits<char>::max(); c++) {
 		CHECK(fsv::filtered_string_view::default_predicate(c));
@@ -107,6 +109,42 @@ TEST_CASE("Test Subscript") {
 	CHECK(fsv1[2] == expected);
 }
 
+TEST_CASE("Test Subscript -- after copy and assignment") {
+	auto pred = [](const char& c) { return c == '9' || c == '0' || c == ' '; };
+	auto fsv1 = fsv::filtered_string_view{"only 90s kids understand", pred};
+	CHECK(fsv1[1] == '9');
+	auto fsv2 = fsv1;
+	CHECK(fsv2[2] == '0');
+	CHECK(fsv2.at(3) == ' ');
+	fsv2 = fsv::filtered_string_view{"kids", [](const char& c) { return c != 'i'; }};
+	CHECK(fsv2[1] == 'd');
+	CHECK(fsv2.at(2) == 's');
+	CHECK(fsv1[2] == '0');
+}
+
+TEST_CASE("Test Subscript -- concurrent readers of one view") {
+	auto pred = [](const char& c) { return c == '9' || c == '0' || c == ' '; };
+	const auto fsv1 = fsv::filtered_string_view{"only 90s kids understand", pred};
+	auto seen = std::vector<std::string>(4);
+	auto readers = std::vector<std::thread>{};
+	for (std::size_t t = 0; t < seen.size(); ++t) {
+		readers.emplace_back([&fsv1, &seen, t] {
+			// Half the readers index a copy, which shares the table of the view it came from.
+			const auto copy = fsv1;
+			const auto& view = t % 2 == 0 ? fsv1 : copy;
+			for (std::size_t i = 0; i < view.size(); ++i) {
+				seen[t] += view[i];
+			}
+		});
+	}
+	for (auto& reader : readers) {
+		reader.join();
+	}
+	for (const auto& s : seen) {
+		CHECK(s == " 90  ");
+	}
+}
+
 TEST_CASE("Test String Type Conversion") {
 	auto sv = fsv::filtered_string_view("vizsla");
 	auto s = static_cast<std::string>(sv);
@@ -159,6 +197,20 @@ TEST_CASE("Test size method with specified predicate") {
 	CHECK(sv.size() == expected);
 }
 
+TEST_CASE("Test size method -- after copy, move and assignment") {
+	auto sv = fsv::filtered_string_view{"Toy Poodle", [](const char& c) { return c == 'o'; }};
+	CHECK(sv.size() == 3);
+	auto copy = sv;
+	CHECK(copy.size() == 3);
+	auto moved = std::move(sv);
+	CHECK(moved.size() == 3);
+	CHECK(sv.size() == 0);
+	copy = fsv::filtered_string_view{"Poodle"};
+	CHECK(copy.size() == 6);
+	CHECK(copy[5] == 'e');
+	CHECK(moved.size() == 3);
+}
+
 TEST_CASE("Test empty method with default predicate") {
 	auto sv = fsv::filtered_string_view{"Australian Shephard"};
 	auto empty_sv = fsv::filtered_string_view{};
@@ -210,6 +262,24 @@ TEST_CASE("Test Relational Comparison") {
 	CHECK((lo <=> hi) == std::strong_ordering::less);
 }
 
+TEST_CASE("Test Relational Comparison -- filtered, shortest first") {
+	auto no_vowels = [](const char& c) { return c != 'a' && c != 'e' && c != 'i' && c != 'o' && c != 'u'; };
+	auto const husky = fsv::filtered_string_view{"husky", no_vowels};
+	auto const hsk = fsv::filtered_string_view{"hsk"};
+	auto const beagle = fsv::filtered_string_view{"beagle", no_vowels};
+	CHECK(husky == fsv::filtered_string_view{"hsky"});
+	CHECK(hsk < husky);
+	CHECK((beagle <=> hsk) == std::strong_ordering::less);
+	CHECK((husky <=> fsv::filtered_string_view{"hskz"}) == std::strong_ordering::less);
+
+	auto views = std::vector<fsv::filtered_string_view>{husky, beagle, hsk, fsv::filtered_string_view{}};
+	std::sort(views.begin(), views.end());
+	CHECK(views[0].empty());
+	CHECK(static_cast<std::string>(views[1]) == "bgl");
+	CHECK(static_cast<std::string>(views[2]) == "hsk");
+	CHECK(static_cast<std::string>(views[3]) == "hsky");
+}
+
 TEST_CASE("Test Output Stream") {
 	auto fsv = fsv::filtered_string_view{"c++ > rust > java", [](const char& c) { return c == 'c' || c == '+'; }};
 	std::ostringstream x;